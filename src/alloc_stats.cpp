@@ -0,0 +1,102 @@
+#include "alloc_stats.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+thread_local AllocationCounters counters = {0, 0};
+
+void* counted_alloc(size_t size) {
+  counters.allocations += 1;
+  counters.bytes += size;
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* counted_aligned_alloc(size_t size, std::align_val_t alignment) {
+  counters.allocations += 1;
+  counters.bytes += size;
+  size_t align = static_cast<size_t>(alignment);
+  size_t rounded = (size + align - 1) / align * align;
+#ifdef _WIN32
+  void* ptr = _aligned_malloc(rounded == 0 ? align : rounded, align);
+#else
+  void* ptr = std::aligned_alloc(align, rounded == 0 ? align : rounded);
+#endif
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void aligned_free(void* ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+}  // namespace
+
+AllocationCounters thread_allocations() {
+  return counters;
+}
+
+AllocationCounters operator-(const AllocationCounters& lhs,
+                             const AllocationCounters& rhs) {
+  return {lhs.allocations - rhs.allocations, lhs.bytes - rhs.bytes};
+}
+
+void* operator new(size_t size) {
+  return counted_alloc(size);
+}
+
+void* operator new[](size_t size) {
+  return counted_alloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return counted_aligned_alloc(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return counted_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  aligned_free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+  aligned_free(ptr);
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts of global operator new calls. Linking alloc_stats.cpp replaces the
+// global allocation functions, so every C++ heap allocation is counted.
+struct AllocationCounters {
+  uint64_t allocations;
+  uint64_t bytes;
+};
+
+// Totals for the calling thread only, so other threads (search, map
+// generation) do not show up in the main loop's per-frame numbers.
+AllocationCounters thread_allocations();
+
+AllocationCounters operator-(const AllocationCounters& lhs,
+                             const AllocationCounters& rhs);
+
+#endif  // ALLOC_STATS_H
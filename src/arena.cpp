@@ -0,0 +1,52 @@
+#include "arena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t capacity)
+    : buffer_(new std::byte[capacity])
+    , capacity_(capacity)
+    , used_(0)
+    , high_water_(0)
+    , overflow_bytes_(0) {}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+  size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+  if (offset + bytes <= capacity_) {
+    used_ = offset + bytes;
+    return buffer_.get() + offset;
+  }
+  // new[] of bytes is only aligned to the default new alignment, which
+  // covers everything stored in frame containers.
+  overflow_bytes_ += bytes;
+  overflow_.emplace_back(new std::byte[bytes]);
+  return overflow_.back().get();
+}
+
+void FrameArena::reset() {
+  high_water_ = std::max(high_water_, used_ + overflow_bytes_);
+  if (overflow_bytes_ > 0) {
+    capacity_ = std::max(capacity_ * 2, high_water_);
+    buffer_.reset(new std::byte[capacity_]);
+    overflow_.clear();
+    overflow_bytes_ = 0;
+  }
+  used_ = 0;
+}
+
+size_t FrameArena::used() const {
+  return used_ + overflow_bytes_;
+}
+
+size_t FrameArena::capacity() const {
+  return capacity_;
+}
+
+size_t FrameArena::highWater() const {
+  return std::max(high_water_, used());
+}
+
+void FrameArena::reportMemory(MemoryReport& report) const {
+  report.add(MemoryCategory::FRAME, "frame arena",
+             capacity_ + overflow_bytes_ +
+                 overflow_.capacity() * sizeof(overflow_[0]));
+}
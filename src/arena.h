@@ -0,0 +1,68 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "memory.h"
+
+// Bump allocator for containers that only live for one frame. Everything is
+// released at once by reset(). Allocations that do not fit fall back to the
+// heap and the arena grows at the next reset, so a steady-state frame never
+// touches the heap.
+class FrameArena {
+ public:
+  explicit FrameArena(size_t capacity);
+
+  void* allocate(size_t bytes, size_t alignment);
+  void reset();
+
+  size_t used() const;
+  size_t capacity() const;
+  size_t highWater() const;
+
+  void reportMemory(MemoryReport& report) const;
+
+ private:
+  std::unique_ptr<std::byte[]> buffer_;
+  size_t capacity_;
+  size_t used_;
+  size_t high_water_;
+  size_t overflow_bytes_;
+  std::vector<std::unique_ptr<std::byte[]>> overflow_;
+};
+
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena& arena)
+      : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, size_t) {}
+
+  FrameArena* arena() const {
+    return arena_;
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+
+ private:
+  FrameArena* arena_;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif  // ARENA_H
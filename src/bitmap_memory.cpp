@@ -0,0 +1,14 @@
+#include "bitmap_memory.h"
+
+MemoryUsage bitmap_memory(ALLEGRO_BITMAP* bitmap) {
+  if (!bitmap) {
+    return {0, 0};
+  }
+  size_t bytes = static_cast<size_t>(al_get_bitmap_width(bitmap)) *
+                 al_get_bitmap_height(bitmap) *
+                 al_get_pixel_size(al_get_bitmap_format(bitmap));
+  if (al_get_bitmap_flags(bitmap) & ALLEGRO_MEMORY_BITMAP) {
+    return {bytes, 0};
+  }
+  return {0, bytes};
+}
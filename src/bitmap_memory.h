@@ -0,0 +1,12 @@
+#ifndef BITMAP_MEMORY_H
+#define BITMAP_MEMORY_H
+
+#include <allegro5/allegro5.h>
+
+#include "memory.h"
+
+// CPU or GPU bytes behind a bitmap, depending on where Allegro keeps it.
+// Kept apart from memory.h so that the core library does not need Allegro.
+MemoryUsage bitmap_memory(ALLEGRO_BITMAP* bitmap);
+
+#endif  // BITMAP_MEMORY_H
@@ -0,0 +1,196 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "png.h"
+
+namespace {
+// Frames that can be waiting for the encoder at once. At 400x300 this is
+// under 4 MB and rides out a few slow writes.
+constexpr int CAPTURE_BUFFERS = 8;
+// Repeats queue without a buffer, so the queue is longer than the pool.
+constexpr size_t QUEUE_CAPACITY = 64;
+constexpr size_t FRAME_DIGITS = 6;
+}  // namespace
+
+FrameCapture::FrameCapture(const std::string& path, CaptureFormat format,
+                           int width, int height)
+    : path_(path)
+    , format_(format)
+    , width_(width)
+    , height_(height)
+    , good_(true)
+    , queue_(QUEUE_CAPACITY, 0)
+    , queue_head_(0)
+    , queue_size_(0)
+    , stopping_(false)
+    , captured_(false)
+    , stats_({0, 0, 0, 0})
+    , next_index_(0) {
+  if (format_ == CaptureFormat::RAW) {
+    raw_.open(path_, std::ios::binary | std::ios::trunc);
+    good_ = raw_.good();
+  }
+  size_t frameBytes = static_cast<size_t>(width_) * height_ * 4;
+  for (int i = 0; i < CAPTURE_BUFFERS; ++i) {
+    buffers_.emplace_back(frameBytes);
+    free_.push_back(i);
+  }
+  encoder_ = std::thread(&FrameCapture::encodeLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queued_.notify_one();
+  encoder_.join();
+}
+
+bool FrameCapture::good() const {
+  return good_;
+}
+
+void FrameCapture::capture(ALLEGRO_BITMAP* frame) {
+  auto start = std::chrono::steady_clock::now();
+  int buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.frames;
+    if (free_.empty() || queue_size_ == queue_.size()) {
+      ++stats_.dropped;
+      return;
+    }
+    buffer = free_.back();
+    free_.pop_back();
+  }
+
+  // _LE pins the byte order to R, G, B, A in memory.
+  ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(
+      frame, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+  if (region) {
+    const uint8_t* src = static_cast<const uint8_t*>(region->data);
+    uint8_t* dst = buffers_[buffer].data();
+    size_t rowBytes = static_cast<size_t>(width_) * 4;
+    for (int y = 0; y < height_; ++y) {
+      std::memcpy(dst + y * rowBytes, src + y * region->pitch, rowBytes);
+    }
+    al_unlock_bitmap(frame);
+  }
+
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.lastCaptureMs = elapsed.count();
+  if (!region) {
+    free_.push_back(buffer);
+    ++stats_.dropped;
+    return;
+  }
+  enqueue(buffer);
+}
+
+void FrameCapture::repeat() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!captured_) {
+    return;
+  }
+  ++stats_.frames;
+  if (queue_size_ == queue_.size()) {
+    ++stats_.dropped;
+    return;
+  }
+  enqueue(REPEAT);
+}
+
+void FrameCapture::waitForRoom() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  freed_.wait(lock, [this]() {
+    return !free_.empty() && queue_size_ < queue_.size();
+  });
+}
+
+// Called with mutex_ held.
+void FrameCapture::enqueue(int buffer) {
+  queue_[(queue_head_ + queue_size_) % queue_.size()] = buffer;
+  ++queue_size_;
+  captured_ = true;
+  queued_.notify_one();
+}
+
+void FrameCapture::encodeLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this]() { return queue_size_ > 0 || stopping_; });
+    if (queue_size_ == 0) {
+      return;
+    }
+    int buffer = queue_[queue_head_];
+    queue_head_ = (queue_head_ + 1) % queue_.size();
+    --queue_size_;
+
+    lock.unlock();
+    if (buffer == REPEAT) {
+      writeAgain();
+    } else {
+      write(buffers_[buffer]);
+    }
+    lock.lock();
+
+    if (buffer != REPEAT) {
+      free_.push_back(buffer);
+    }
+    ++stats_.written;
+    freed_.notify_one();
+  }
+}
+
+void FrameCapture::write(const std::vector<uint8_t>& pixels) {
+  if (format_ == CaptureFormat::PNG) {
+    encode_png(pixels.data(), width_ * 4, width_, height_, encoded_);
+  } else {
+    encoded_.assign(pixels.begin(), pixels.end());
+  }
+  writeAgain();
+}
+
+void FrameCapture::writeAgain() {
+  if (encoded_.empty() || !good_) {
+    return;
+  }
+  const char* data = reinterpret_cast<const char*>(encoded_.data());
+  bool ok;
+  if (format_ == CaptureFormat::PNG) {
+    std::string number = std::to_string(next_index_);
+    number.insert(0, FRAME_DIGITS - std::min(FRAME_DIGITS, number.size()),
+                  '0');
+    std::string name = path_ + "-" + number + ".png";
+    std::ofstream out(name, std::ios::binary | std::ios::trunc);
+    ok = out.write(data, encoded_.size()).good();
+  } else {
+    ok = raw_.write(data, encoded_.size()).good();
+  }
+  if (!ok) {
+    std::cerr << "Failed to write capture [" << path_ << "], frame "
+              << next_index_ << std::endl;
+    good_ = false;
+  }
+  ++next_index_;
+}
+
+CaptureStats FrameCapture::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void FrameCapture::reportMemory(MemoryReport& report) const {
+  size_t bytes = 0;
+  for (const std::vector<uint8_t>& buffer : buffers_) {
+    bytes += buffer.capacity();
+  }
+  report.add(MemoryCategory::FRAME, "capture buffers", bytes);
+}
@@ -0,0 +1,100 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <allegro5/allegro5.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "memory.h"
+
+enum class CaptureFormat {
+  // One <path>-NNNNNN.png per frame.
+  PNG,
+  // Every frame appended to <path> as tightly packed RGBA rows, e.g. for
+  // ffmpeg -f rawvideo -pix_fmt rgba -s 400x300 -r 60 -i <path>.
+  RAW,
+};
+
+struct CaptureStats {
+  // Frames handed to capture() or repeat().
+  uint64_t frames;
+  // Frames the encoder has finished with.
+  uint64_t written;
+  // Frames lost because every buffer was still waiting for the encoder.
+  uint64_t dropped;
+  // Render thread time of the last capture(): the readback and one copy.
+  double lastCaptureMs;
+};
+
+// Copies finished frames into a fixed pool of buffers and writes them out
+// on a background thread, so the frame loop pays only for reading the frame
+// back. When the encoder falls behind and every buffer is in flight, frames
+// are dropped and counted rather than stalling the frame loop.
+class FrameCapture {
+ public:
+  FrameCapture(const std::string& path, CaptureFormat format, int width,
+               int height);
+  FrameCapture(const FrameCapture&) = delete;
+  FrameCapture& operator=(const FrameCapture&) = delete;
+  // Writes out every queued frame before returning.
+  ~FrameCapture();
+
+  bool good() const;
+  void capture(ALLEGRO_BITMAP* frame);
+  // The frame loop skipped drawing a frame, because nothing changed or
+  // because the tick was folded into a later one; the previous frame is
+  // written again so the recording keeps the frame rate.
+  void repeat();
+  // Blocks until the next capture() or repeat() will not be dropped. For
+  // offline recording, where every frame matters more than the frame rate.
+  void waitForRoom();
+
+  CaptureStats stats() const;
+  void reportMemory(MemoryReport& report) const;
+
+ private:
+  // A queued frame: a buffer index, or REPEAT.
+  static constexpr int REPEAT = -1;
+
+  void enqueue(int buffer);
+  void encodeLoop();
+  void write(const std::vector<uint8_t>& pixels);
+  void writeAgain();
+
+ private:
+  std::string path_;
+  CaptureFormat format_;
+  int width_;
+  int height_;
+  std::ofstream raw_;
+  // Cleared by the encoder when a write fails.
+  std::atomic<bool> good_;
+
+  std::vector<std::vector<uint8_t>> buffers_;
+  // Guarded by mutex_: buffers the frame loop may fill, and a ring of
+  // queued frames for the encoder.
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable freed_;
+  std::vector<int> free_;
+  std::vector<int> queue_;
+  size_t queue_head_;
+  size_t queue_size_;
+  bool stopping_;
+  bool captured_;
+  CaptureStats stats_;
+
+  // Encoder thread only.
+  std::vector<uint8_t> encoded_;
+  uint64_t next_index_;
+  std::thread encoder_;
+};
+
+#endif  // CAPTURE_H
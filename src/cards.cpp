@@ -0,0 +1,245 @@
+#include "cards.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+// One block per card:
+//   card NAME                  unique; the first card is id 0, and so on
+//   texture PATH               card face
+//   amount N                   copies in the starting deck
+//   target TILES...            terrain the played-on tile must have
+//   holding OBJECTS...         object the played-on tile must hold
+//   direction                  the play also needs a unit hex direction
+//   footprint disc N | ring N | ray
+//   affects TILES...           terrain of footprint tiles that are affected
+//   showing OBJECTS...         objects of affected tiles the preview marks
+//   transform FROM TO FRAMES   object change when played
+//   tint R G B                 preview tint
+// "any" stands for every terrain but NONE, or for every object.
+constexpr std::string_view DEFAULT_CARDS = R"(
+card RAIN_M
+  texture assets/textures/card-rain-m.png
+  amount 2
+  target CONTROL GRASS LUSH_GRASS MOSS SAND TREE
+  holding any
+  footprint disc 1
+  affects GRASS LUSH_GRASS MOSS SAND TREE
+  showing any
+  transform SPORES SHROOM 4
+  tint 0.0 0.3 0.5
+
+card SPORES_M
+  texture assets/textures/card-spores-m.png
+  amount 1
+  target any
+  holding SHROOM
+  footprint ring 1
+  affects GRASS LUSH_GRASS MOSS SAND TREE
+  showing NONE
+  transform NONE SPORES 5
+  tint 0.5 0.0 0.5
+
+card WIND_M
+  texture assets/textures/card-wind-m.png
+  amount 1
+  target CONTROL
+  holding any
+  direction
+  footprint ray
+  affects GRASS LUSH_GRASS MOSS SAND TREE
+  showing any
+  tint 0.5 0.5 0.5
+)";
+
+constexpr std::pair<std::string_view, TileType> TILE_NAMES[] = {
+    {"NONE", TileType::NONE},   {"CONTROL", TileType::CONTROL},
+    {"GRASS", TileType::GRASS}, {"LUSH_GRASS", TileType::LUSH_GRASS},
+    {"MOSS", TileType::MOSS},   {"SAND", TileType::SAND},
+    {"TREE", TileType::TREE},
+};
+
+constexpr std::pair<std::string_view, Object> OBJECT_NAMES[] = {
+    {"NONE", Object::NONE},
+    {"SHROOM", Object::SHROOM},
+    {"SHROOMS", Object::SHROOMS},
+    {"SPORES", Object::SPORES},
+};
+
+template <typename T, size_t N>
+std::optional<T> lookup(const std::pair<std::string_view, T> (&names)[N],
+                        std::string_view name) {
+  for (const auto& [key, value] : names) {
+    if (key == name) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<uint8_t> parse_tiles(std::istringstream& in) {
+  uint8_t mask = 0;
+  std::string word;
+  while (in >> word) {
+    if (word == "any") {
+      mask |= static_cast<uint8_t>(~tile_bit(TileType::NONE));
+    } else if (auto type = lookup(TILE_NAMES, word)) {
+      mask |= tile_bit(*type);
+    } else {
+      return std::nullopt;
+    }
+  }
+  return mask;
+}
+
+std::optional<uint8_t> parse_objects(std::istringstream& in) {
+  uint8_t mask = 0;
+  std::string word;
+  while (in >> word) {
+    if (word == "any") {
+      mask |= 0xff;
+    } else if (auto obj = lookup(OBJECT_NAMES, word)) {
+      mask |= object_bit(*obj);
+    } else {
+      return std::nullopt;
+    }
+  }
+  return mask;
+}
+
+std::vector<Hex3> footprint_offsets(int radius, bool ringOnly) {
+  std::vector<Hex3> offsets;
+  for (int q = -radius; q <= radius; ++q) {
+    for (int r = -radius; r <= radius; ++r) {
+      int s = -q - r;
+      int distance = std::max({std::abs(q), std::abs(r), std::abs(s)});
+      if (distance <= radius && (!ringOnly || distance == radius)) {
+        offsets.push_back({q, r, s});
+      }
+    }
+  }
+  return offsets;
+}
+
+bool parse_line(CardEffect& effect, std::istringstream& in,
+                const std::string& key) {
+  if (key == "texture") {
+    return static_cast<bool>(in >> effect.texture);
+  }
+  if (key == "amount") {
+    return static_cast<bool>(in >> effect.amount);
+  }
+  if (key == "target") {
+    auto mask = parse_tiles(in);
+    effect.targetTiles = mask.value_or(0);
+    return mask.has_value();
+  }
+  if (key == "holding") {
+    auto mask = parse_objects(in);
+    effect.targetObjects = mask.value_or(0);
+    return mask.has_value();
+  }
+  if (key == "direction") {
+    effect.directional = true;
+    return true;
+  }
+  if (key == "footprint") {
+    std::string shape;
+    int radius = 0;
+    in >> shape;
+    if (shape == "ray") {
+      effect.ray = true;
+      return true;
+    }
+    if ((shape != "disc" && shape != "ring") || !(in >> radius) ||
+        radius < 0) {
+      return false;
+    }
+    effect.offsets = footprint_offsets(radius, shape == "ring");
+    return true;
+  }
+  if (key == "affects") {
+    auto mask = parse_tiles(in);
+    effect.affectedTiles = mask.value_or(0);
+    return mask.has_value();
+  }
+  if (key == "showing") {
+    auto mask = parse_objects(in);
+    effect.previewObjects = mask.value_or(0);
+    return mask.has_value();
+  }
+  if (key == "transform") {
+    std::string from, to;
+    int frames = 0;
+    in >> from >> to >> frames;
+    auto fromObj = lookup(OBJECT_NAMES, from);
+    auto toObj = lookup(OBJECT_NAMES, to);
+    if (!fromObj || !toObj || frames < 1) {
+      return false;
+    }
+    effect.transforms[static_cast<size_t>(*fromObj)] = {
+        .active = true, .to = *toObj, .frames = frames};
+    return true;
+  }
+  if (key == "tint") {
+    return static_cast<bool>(in >> effect.tint[0] >> effect.tint[1] >>
+                             effect.tint[2]);
+  }
+  return false;
+}
+}  // namespace
+
+std::optional<CardBook> CardBook::parse(std::string_view text) {
+  CardBook book;
+  CardEffect* current = nullptr;
+  std::istringstream lines{std::string(text)};
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(lines, line)) {
+    ++lineNumber;
+    std::istringstream in(line);
+    std::string key;
+    if (!(in >> key) || key[0] == '#') {
+      continue;
+    }
+    bool ok = false;
+    if (key == "card") {
+      std::string name;
+      in >> name;
+      bool taken = std::any_of(
+          book.effects_.begin(), book.effects_.end(),
+          [&name](const CardEffect& effect) { return effect.name == name; });
+      if (!name.empty() && !taken) {
+        current = &book.effects_.emplace_back();
+        current->name = name;
+        ok = true;
+      }
+    } else if (current) {
+      ok = parse_line(*current, in, key);
+    }
+    if (!ok) {
+      std::cerr << "Card definitions, line " << lineNumber << ": cannot parse ["
+                << line << "]" << std::endl;
+      return std::nullopt;
+    }
+  }
+  return book;
+}
+
+size_t CardBook::size() const {
+  return effects_.size();
+}
+
+const CardBook& default_card_book() {
+  static const CardBook book = [] {
+    auto parsed = CardBook::parse(DEFAULT_CARDS);
+    if (!parsed) {
+      exit(1);
+    }
+    return *parsed;
+  }();
+  return book;
+}
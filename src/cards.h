@@ -0,0 +1,72 @@
+#ifndef CARDS_H
+#define CARDS_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "grid.h"
+
+// A card's index in its CardBook, i.e. its position in the definitions.
+using CardId = uint32_t;
+
+constexpr uint8_t tile_bit(TileType type) {
+  return 1 << static_cast<int>(type);
+}
+
+constexpr uint8_t object_bit(Object obj) {
+  return 1 << static_cast<int>(obj);
+}
+
+struct CardTransform {
+  bool active;
+  Object to;
+  // The new object starts on a random frame in [0, frames).
+  int frames;
+};
+
+// A card definition compiled into lookup tables: the footprint is a list of
+// offsets from the target, filters are bit masks over TileType and Object,
+// and the transformation is a table indexed by the affected tile's object.
+struct CardEffect {
+  std::string name;
+  // Card face, relative to the resources path.
+  std::string texture;
+  int amount;
+  uint8_t targetTiles;
+  uint8_t targetObjects;
+  bool directional;
+  // Footprint runs from the target along the move direction to the map edge
+  // instead of using offsets.
+  bool ray;
+  std::vector<Hex3> offsets;
+  uint8_t affectedTiles;
+  uint8_t previewObjects;
+  std::array<CardTransform, OBJECT_COUNT> transforms;
+  std::array<float, 3> tint;
+};
+
+class CardBook {
+ public:
+  // Compiles the text format described at the top of cards.cpp. Errors are
+  // reported on stderr.
+  static std::optional<CardBook> parse(std::string_view text);
+
+  const CardEffect& effect(CardId id) const {
+    return effects_[id];
+  }
+  // Cards are numbered in definition order, which is also the starting
+  // deck order.
+  size_t size() const;
+
+ private:
+  std::vector<CardEffect> effects_;
+};
+
+// The built-in card definitions, compiled on first use.
+const CardBook& default_card_book();
+
+#endif  // CARDS_H
@@ -1,23 +1,45 @@
 #include "controller.h"
 
-#include <iostream>
-
 #include "data.h"
 #include "util.h"
 
-Controller::Controller()
+Controller::Controller(uint32_t seed)
     : mousePos({0, 0})
-    , mouseButton(0) {}
+    , mouseButton(0)
+    , generator_(seed) {}
+
+void Controller::step(Game& game, const InputFrame& input) {
+  mousePos = input.mousePos;
+  if (input.mouseButton != 0) {
+    mouseButton = input.mouseButton;
+  }
+  if (input.timestamp > 0 && !input_time_) {
+    input_time_ = input.timestamp;
+  }
+  if (input.command == InputCommand::UNDO) {
+    history_.undo(game);
+  } else if (input.command == InputCommand::REDO) {
+    history_.redo(game);
+  }
+  if (!game.gameover) {
+    command(game);
+  }
+  game.update(input.dt);
+}
+
+std::optional<double> Controller::takeInputTime() {
+  std::optional<double> time = input_time_;
+  input_time_ = std::nullopt;
+  return time;
+}
 
 void Controller::command(Game& game) {
   Vec2i gridOrigin = vec2i(GRID_ORIGIN);
   Vec2i gridMousePos = mousePos - gridOrigin;
   Hex3 tileCoord = point2hex(gridMousePos, HEX_SIZE);
   game.hoveredTile = std::nullopt;
-  if (tileCoord.q >= 0 && tileCoord.q < static_cast<int>(game.map.size()) &&
-      tileCoord.r >= 0 &&
-      tileCoord.r < static_cast<int>(game.map.at(0).size())) {
-    if (game.map[tileCoord.q][tileCoord.r].type != TileType::NONE) {
+  if (game.validTile(tileCoord)) {
+    if (game.map.at(tileCoord.q, tileCoord.r).type() != TileType::NONE) {
       game.hoveredTile = tileCoord;
     }
   }
@@ -38,86 +60,40 @@ void Controller::command(Game& game) {
   }
 
   game.affectedTiles.clear();
-  auto activeCard = game.activeCard();
-  auto activeTile = game.activeTile();
+  const Card& activeCard = game.peekActiveCard();
+  const Tile* activeTile = game.activeTile();
+  std::optional<Move> move;
   if (game.selectedCard && activeTile) {
     Hex3 target = *game.hoveredTile;
-    std::vector<Hex3> maybeAffected;
-    if (activeCard.type == CardType::SPORES_M &&
-        activeTile->obj == Object::SHROOM) {
-      maybeAffected.push_back({target.q - 1, target.r + 1, target.s});
-      maybeAffected.push_back({target.q - 1, target.r, target.s + 1});
-      maybeAffected.push_back({target.q + 1, target.r - 1, target.s});
-      maybeAffected.push_back({target.q + 1, target.r, target.s - 1});
-      maybeAffected.push_back({target.q, target.r + 1, target.s - 1});
-      maybeAffected.push_back({target.q, target.r - 1, target.s + 1});
-    } else if (activeCard.type == CardType::RAIN_M) {
-      maybeAffected.push_back(target);
-      maybeAffected.push_back({target.q - 1, target.r + 1, target.s});
-      maybeAffected.push_back({target.q - 1, target.r, target.s + 1});
-      maybeAffected.push_back({target.q + 1, target.r - 1, target.s});
-      maybeAffected.push_back({target.q + 1, target.r, target.s - 1});
-      maybeAffected.push_back({target.q, target.r + 1, target.s - 1});
-      maybeAffected.push_back({target.q, target.r - 1, target.s + 1});
-    } else if (activeCard.type == CardType::WIND_M &&
-               activeCard.selectingDirection) {
-      int qdiff = activeTile->coords.q - game.selectedTile->q;
-      int rdiff = activeTile->coords.r - game.selectedTile->r;
-      std::cout << qdiff << " " << rdiff << std::endl;
-      if ((qdiff != 0 || rdiff != 0) && abs(qdiff + rdiff) <= 1 &&
-          abs(qdiff) <= 1 && abs(rdiff) <= 1) {
-        Hex3 next = target;
-        while (game.validTile(next)) {
-          maybeAffected.push_back(next);
-          next = {next.q + qdiff, next.r + rdiff, next.s - qdiff - rdiff};
-        }
+    if (game.effectOf(*game.selectedCard).directional) {
+      if (activeCard.selectingDirection) {
+        Hex3 origin = *game.selectedTile;
+        move = {*game.selectedCard,
+                origin,
+                {target.q - origin.q, target.r - origin.r,
+                 target.s - origin.s}};
       }
+    } else {
+      move = {*game.selectedCard, target, {0, 0, 0}};
     }
-    for (Hex3 hex : maybeAffected) {
-      if (game.validTile(hex)) {
-        Tile tile = game.tileAt(hex);
-        if (tile.type == TileType::NONE || tile.type == TileType::CONTROL) {
-          continue;
-        }
-        if (activeCard.type == CardType::RAIN_M) {
-          game.affectedTiles.push_back(hex);
-        } else if (activeCard.type == CardType::SPORES_M) {
-          if (tile.obj == Object::NONE) {
-            game.affectedTiles.push_back(hex);
-          }
-        } else if (activeCard.type == CardType::WIND_M) {
-          game.affectedTiles.push_back(hex);
-        }
-      }
+    if (move) {
+      game.affectedBy(*move, game.affectedTiles);
     }
   }
 
   if (mouseButton == 1) {
     if (game.selectedCard && activeTile) {
-      if (activeCard.type == CardType::SPORES_M &&
-          activeTile->obj == Object::SHROOM) {
-        std::uniform_int_distribution<> distrib(0, 4);
-        for (Hex3 hex : game.affectedTiles) {
-          Tile& tile = game.tileAt(hex);
-          if (tile.obj == Object::NONE) {
-            tile.obj = Object::SPORES;
-            tile.obj_frame = distrib(generator_);
-          }
-        }
-      } else if (activeCard.type == CardType::RAIN_M) {
-        std::uniform_int_distribution<> distrib(0, 3);
-        for (Hex3 hex : game.affectedTiles) {
-          Tile& tile = game.tileAt(hex);
-          if (tile.obj == Object::SPORES) {
-            tile.obj = Object::SHROOM;
-            tile.obj_frame = distrib(generator_);
-          }
+      const CardEffect& effect = game.effectOf(*game.selectedCard);
+      if (effect.directional && activeCard.selectingOrigin) {
+        if (effect.targetTiles & tile_bit(activeTile->type())) {
+          game.activeCard().selectingOrigin = false;
+          game.activeCard().selectingDirection = true;
+          game.selectedTile = game.hoveredTile;
         }
-      } else if (activeCard.type == CardType::WIND_M &&
-                 activeCard.selectingOrigin) {
-        game.activeCard().selectingOrigin = false;
-        game.activeCard().selectingDirection = true;
-        game.selectedTile = activeTile->coords;
+      } else if (move && !effect.directional && game.legal(*move)) {
+        history_.record(game);
+        game.play(*move, generator_);
+        game.highlightedTiles.clear();
       }
     } else if (game.hoveredCard) {
       game.selectedCard = game.hoveredCard;
@@ -127,3 +103,8 @@ void Controller::command(Game& game) {
     mouseButton = 0;
   }
 }
+
+void Controller::reportMemory(MemoryReport& report,
+                              const Game& game) const {
+  history_.reportMemory(report, game.map);
+}
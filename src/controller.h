@@ -2,14 +2,38 @@
 #define CONTROLLER_H
 
 #include "game.h"
+#include "history.h"
+
+enum class InputCommand {
+  NONE,
+  UNDO,
+  REDO,
+};
+
+struct InputFrame {
+  uint32_t dt;
+  Vec2i mousePos;
+  int mouseButton;
+  InputCommand command;
+  // al_get_time() of the oldest input event folded into this frame, or 0.
+  // Only used for latency measurement and not journaled.
+  double timestamp;
+};
 
 class Controller
 {
  public:
-  Controller();
+  explicit Controller(
+      uint32_t seed = std::default_random_engine::default_seed);
 
   void mouseClick(int button);
   void command(Game& game);
+  void step(Game& game, const InputFrame& input);
+  // Timestamp of the oldest input applied since the last call, so the
+  // caller can measure latency once the frame showing it is presented.
+  std::optional<double> takeInputTime();
+
+  void reportMemory(MemoryReport& report, const Game& game) const;
 
  public:
   Vec2i mousePos;
@@ -17,6 +41,8 @@ class Controller
 
  private:
   std::default_random_engine generator_;
+  History history_;
+  std::optional<double> input_time_;
 };
 
 #endif // CONTROLLER_H
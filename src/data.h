@@ -21,9 +21,6 @@ enum class Texture {
   OBJECT_SPORES_01,
   OBJECT_SPORES_02,
   OBJECT_SPORES_03,
-  CARD_RAIN_M,
-  CARD_SPORES_M,
-  CARD_WIND_M,
 };
 
 struct Rect {
@@ -47,6 +44,10 @@ struct Hex3 {
   int q, r, s;
 };
 
+constexpr Hex3 HEX_DIRECTIONS[] = {
+    {-1, 1, 0}, {-1, 0, 1}, {1, -1, 0}, {1, 0, -1}, {0, 1, -1}, {0, -1, 1},
+};
+
 struct Quad {
   Vec3 a, b, c, d;
 };
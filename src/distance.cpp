@@ -0,0 +1,218 @@
+#include "distance.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "parallel.h"
+
+namespace {
+// Below these sizes thread start-up costs more than the work it splits.
+constexpr size_t PARALLEL_TILES = 1 << 16;
+constexpr size_t PARALLEL_FRONTIER = 1 << 13;
+constexpr size_t BLOCKS_PER_THREAD = 4;
+}  // namespace
+
+DistanceField::DistanceField(const DistanceRules& rules)
+    : rules_(rules)
+    , width_(0)
+    , height_(0) {}
+
+int DistanceField::width() const {
+  return width_;
+}
+
+int DistanceField::height() const {
+  return height_;
+}
+
+bool DistanceField::isSource(const Tile& tile) const {
+  return rules_.sourceObjects & object_bit(tile.obj());
+}
+
+void DistanceField::compute(const Grid& map, unsigned threads) {
+  width_ = map.width();
+  height_ = map.height();
+  size_t count = static_cast<size_t>(width_) * height_;
+  distance_.assign(count, UNREACHABLE);
+  passable_.assign(count, 0);
+  unsigned workers = count >= PARALLEL_TILES ? worker_count(threads) : 1;
+
+  parallel_for(
+      width_,
+      [this, &map](size_t q) {
+        for (int r = 0; r < height_; ++r) {
+          const Tile& tile = map.at(q, r);
+          size_t i = index(q, r);
+          passable_[i] = (rules_.passableTiles & tile_bit(tile.type())) != 0;
+          if (isSource(tile)) {
+            distance_[i] = 0;
+          }
+        }
+      },
+      workers);
+
+  frontier_.clear();
+  for (size_t i = 0; i < count; ++i) {
+    if (distance_[i] == 0) {
+      frontier_.push_back(i);
+    }
+  }
+  for (uint16_t level = 0; !frontier_.empty() && level < UNREACHABLE - 1;
+       ++level) {
+    if (workers > 1 && frontier_.size() >= PARALLEL_FRONTIER) {
+      expandParallel(level, workers);
+    } else {
+      expand(level);
+    }
+    std::swap(frontier_, next_);
+  }
+}
+
+void DistanceField::expand(uint16_t level) {
+  next_.clear();
+  for (uint32_t i : frontier_) {
+    forEachNeighbor(i, [&](uint32_t j) {
+      if (passable_[j] && distance_[j] == UNREACHABLE) {
+        distance_[j] = level + 1;
+        next_.push_back(j);
+      }
+    });
+  }
+}
+
+void DistanceField::expandParallel(uint16_t level, unsigned threads) {
+  size_t blockCount = threads * BLOCKS_PER_THREAD;
+  blocks_.resize(blockCount);
+  parallel_for(
+      blockCount,
+      [this, level, blockCount](size_t block) {
+        std::vector<uint32_t>& out = blocks_[block];
+        out.clear();
+        size_t begin = frontier_.size() * block / blockCount;
+        size_t end = frontier_.size() * (block + 1) / blockCount;
+        for (size_t k = begin; k < end; ++k) {
+          forEachNeighbor(frontier_[k], [&](uint32_t j) {
+            if (passable_[j]) {
+              // Several blocks can reach the same tile; only the one that
+              // claims it adds it to the next frontier.
+              std::atomic_ref<uint16_t> distance(distance_[j]);
+              uint16_t expected = UNREACHABLE;
+              if (distance.load(std::memory_order_relaxed) == UNREACHABLE &&
+                  distance.compare_exchange_strong(
+                      expected, level + 1, std::memory_order_relaxed)) {
+                out.push_back(j);
+              }
+            }
+          });
+        }
+      },
+      threads);
+  next_.clear();
+  for (const std::vector<uint32_t>& block : blocks_) {
+    next_.insert(next_.end(), block.begin(), block.end());
+  }
+}
+
+void DistanceField::update(const Grid& map, Hex3 hex) {
+  if (hex.q < 0 || hex.q >= width_ || hex.r < 0 || hex.r >= height_) {
+    return;
+  }
+  uint32_t i = index(hex.q, hex.r);
+  bool source = isSource(map.at(hex.q, hex.r));
+  if (source == (distance_[i] == 0)) {
+    return;
+  }
+  if (source) {
+    distance_[i] = 0;
+    frontier_.assign(1, i);
+    propagateDecrease();
+  } else {
+    repairIncrease(i);
+  }
+}
+
+void DistanceField::propagateDecrease() {
+  while (!frontier_.empty()) {
+    next_.clear();
+    for (uint32_t i : frontier_) {
+      uint16_t next = distance_[i] + 1;
+      forEachNeighbor(i, [&](uint32_t j) {
+        if (passable_[j] && distance_[j] > next) {
+          distance_[j] = next;
+          next_.push_back(j);
+        }
+      });
+    }
+    std::swap(frontier_, next_);
+  }
+}
+
+void DistanceField::repairIncrease(uint32_t removed) {
+  // Invalidate, one level at a time, every tile that was only reachable
+  // through the removed source: a tile at level + 1 keeps its distance if
+  // any neighbor is still valid at level.
+  distance_[removed] = UNREACHABLE;
+  frontier_.assign(1, removed);
+  invalid_.assign(1, removed);
+  for (uint16_t level = 0; !frontier_.empty(); ++level) {
+    next_.clear();
+    for (uint32_t i : frontier_) {
+      forEachNeighbor(i, [&](uint32_t j) {
+        if (!passable_[j] || distance_[j] != level + 1) {
+          return;
+        }
+        bool supported = false;
+        forEachNeighbor(j, [&](uint32_t k) {
+          supported = supported || distance_[k] == level;
+        });
+        if (!supported) {
+          distance_[j] = UNREACHABLE;
+          next_.push_back(j);
+          invalid_.push_back(j);
+        }
+      });
+    }
+    std::swap(frontier_, next_);
+  }
+
+  // Seed every invalidated tile with its best valid neighbor, bucketed by
+  // the resulting distance, then settle the buckets in increasing order.
+  size_t lowest = UNREACHABLE;
+  for (uint32_t i : invalid_) {
+    if (!passable_[i]) {
+      continue;
+    }
+    uint32_t best = UNREACHABLE;
+    forEachNeighbor(i, [&](uint32_t j) {
+      best = std::min<uint32_t>(best, distance_[j] + 1u);
+    });
+    if (best < UNREACHABLE) {
+      if (buckets_.size() <= best) {
+        buckets_.resize(best + 1);
+      }
+      buckets_[best].push_back(i);
+      lowest = std::min<size_t>(lowest, best);
+    }
+  }
+  for (size_t level = lowest; level < buckets_.size(); ++level) {
+    for (size_t k = 0; k < buckets_[level].size(); ++k) {
+      uint32_t i = buckets_[level][k];
+      if (distance_[i] <= level) {
+        continue;
+      }
+      distance_[i] = level;
+      if (level + 1 >= UNREACHABLE) {
+        continue;
+      }
+      forEachNeighbor(i, [&](uint32_t j) {
+        if (passable_[j] && distance_[j] > level + 1) {
+          if (buckets_.size() <= level + 1) {
+            buckets_.resize(level + 2);
+          }
+          buckets_[level + 1].push_back(j);
+        }
+      });
+    }
+    buckets_[level].clear();
+  }
+}
@@ -0,0 +1,91 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "cards.h"
+#include "grid.h"
+
+// Which tiles seed a distance field and which terrain it can spread over,
+// as bit masks over Object and TileType like the card filters.
+struct DistanceRules {
+  uint8_t sourceObjects;
+  uint8_t passableTiles;
+};
+
+// Mushrooms of any kind, spreading over playable terrain but not trees.
+constexpr DistanceRules SHROOM_DISTANCE = {
+    .sourceObjects = object_bit(Object::SHROOM) | object_bit(Object::SHROOMS),
+    .passableTiles = tile_bit(TileType::GRASS) |
+                     tile_bit(TileType::LUSH_GRASS) | tile_bit(TileType::MOSS) |
+                     tile_bit(TileType::SAND),
+};
+
+// Hex steps from every tile to the nearest source, moving only through
+// passable terrain. Sources count as distance 0 whatever they stand on.
+// Built by a multi-source BFS one frontier (distance) at a time; after
+// that, a change to a single tile's object is repaired locally by update()
+// instead of rebuilding the whole field.
+class DistanceField {
+ public:
+  static constexpr uint16_t UNREACHABLE = 0xffff;
+
+  explicit DistanceField(const DistanceRules& rules);
+
+  // Full rebuild. Frontiers large enough to pay for it are expanded on
+  // `threads` threads (0 uses every hardware thread).
+  void compute(const Grid& map, unsigned threads = 0);
+  // Repairs the field after the object on hex changed. Terrain is assumed
+  // unchanged since compute().
+  void update(const Grid& map, Hex3 hex);
+
+  int width() const;
+  int height() const;
+  uint16_t at(int q, int r) const {
+    return distance_[index(q, r)];
+  }
+
+ private:
+  size_t index(int q, int r) const {
+    return static_cast<size_t>(q) * height_ + r;
+  }
+  bool isSource(const Tile& tile) const;
+
+  template <typename F>
+  void forEachNeighbor(uint32_t i, F f) const {
+    int q = static_cast<int>(i / height_);
+    int r = static_cast<int>(i % height_);
+    for (Hex3 dir : HEX_DIRECTIONS) {
+      int nq = q + dir.q;
+      int nr = r + dir.r;
+      if (nq >= 0 && nq < width_ && nr >= 0 && nr < height_) {
+        f(static_cast<uint32_t>(index(nq, nr)));
+      }
+    }
+  }
+
+  // Each expands frontier_ (all at distance `level`) into next_.
+  void expand(uint16_t level);
+  void expandParallel(uint16_t level, unsigned threads);
+  // Spreads a decrease outwards from frontier_ until nothing improves.
+  void propagateDecrease();
+  // Re-derives the distances of tiles whose nearest source was removed.
+  void repairIncrease(uint32_t removed);
+
+ private:
+  DistanceRules rules_;
+  int width_;
+  int height_;
+  std::vector<uint16_t> distance_;
+  std::vector<uint8_t> passable_;
+
+  // Scratch space kept between calls.
+  std::vector<uint32_t> frontier_;
+  std::vector<uint32_t> next_;
+  std::vector<uint32_t> invalid_;
+  std::vector<std::vector<uint32_t>> blocks_;
+  std::vector<std::vector<uint32_t>> buckets_;
+};
+
+#endif  // DISTANCE_H
@@ -1,11 +1,14 @@
 #include "game.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "util.h"
+#include "zobrist.h"
 
 namespace {
-uint32_t object_frame_duration(Object obj, int frame) {
+// Every frame of an object's animation lasts the same time.
+uint32_t object_frame_duration(Object obj) {
   switch (obj) {
     case Object::SHROOM:
       return 192;
@@ -15,96 +18,103 @@ uint32_t object_frame_duration(Object obj, int frame) {
       return 0;
   }
 }
-int object_next_frame(Object obj, int frame) {
+bool is_direction(Hex3 hex) {
+  return std::any_of(std::begin(HEX_DIRECTIONS), std::end(HEX_DIRECTIONS),
+                     [hex](Hex3 dir) { return dir == hex; });
+}
+
+// Deck keys live above any (q, r) index a map can produce.
+constexpr uint64_t DECK_KEY_BASE = 1ull << 63;
+
+uint64_t tile_key(int q, int r, const Tile& tile) {
+  uint64_t index = static_cast<uint64_t>(q) << 32 | static_cast<uint32_t>(r);
+  return zobrist_key(index, static_cast<uint32_t>(tile.type()) |
+                                static_cast<uint32_t>(tile.obj()) << 8);
+}
+
+uint64_t card_key(size_t slot, const Card& card) {
+  return zobrist_key(DECK_KEY_BASE | slot,
+                     card.id << 16 | static_cast<uint16_t>(card.amount));
+}
+
+int object_frame_count(Object obj) {
   switch (obj) {
     case Object::SHROOM:
-      return (frame + 1) % 4;
+      return 4;
     case Object::SPORES:
-      return (frame + 1) % 5;
+      return 5;
     default:
       return 0;
   }
 }
+
+// Frames of obj's animation completed by game time `time`.
+uint32_t object_frame_steps(Object obj, uint32_t time) {
+  uint32_t duration = object_frame_duration(obj);
+  return duration > 0 ? time / duration : 0;
+}
 }  // namespace
 
-Game::Game()
-    : time_(0) {
-  const int map_size = 11;
-  map.resize(map_size);
-  for (int q = 0; q < map_size; ++q) {
-    map[q].resize(map_size);
-    for (int r = 0; r < map_size; ++r) {
-      map[q][r].coords = {.q = q, .r = r, .s = -q - r};
-    }
-  }
+Game::Game(uint32_t seed, const MapConfig& mapConfig)
+    : map(generate_map(mapConfig, seed))
+    , shape_(mapConfig.shape)
+    , cards_(&default_card_book())
+    , time_(0)
+    , revision_(0)
+    , hash_(0)
+    , generator_(seed) {
+  map.edit(mapConfig.size / 2, mapConfig.size / 2).setObj(Object::SHROOM);
 
-  int cutoff = (map_size - 1) / 2;
-
-  std::uniform_int_distribution<> distrib(1, 2);
-
-  for (auto& row : map) {
-    for (Tile& tile : row) {
-      if (tile.coords.q + tile.coords.r < cutoff ||
-          tile.coords.q + tile.coords.r > 2 * (map_size - 1) - cutoff) {
-        tile.type = TileType::NONE;
-      } else if (tile.coords.q == 0 || tile.coords.q == map_size - 1 ||
-                 tile.coords.r == 0 || tile.coords.r == map_size - 1 ||
-                 tile.coords.s == -cutoff ||
-                 tile.coords.s == -(map_size + cutoff - 1)) {
-        tile.type = TileType::CONTROL;
-      } else {
-        if (distrib(generator_) == 1) {
-          tile.type = TileType::GRASS;
-        } else {
-          tile.type = TileType::LUSH_GRASS;
-        }
-        tile.obj = Object::NONE;
-      }
-    }
+  for (CardId id = 0; id < cards_->size(); ++id) {
+    deck.push_back({.id = id, .amount = cards_->effect(id).amount});
   }
-  map[5][5].obj = Object::SHROOM;
-
-  deck.push_back({.type = CardType::RAIN_M, .amount = 2});
-  deck.push_back({.type = CardType::SPORES_M, .amount = 1});
-  deck.push_back({.type = CardType::WIND_M, .amount = 1});
   selectedCard = 0;
+  hash_ = computeHash();
+  summary_.build(map);
 }
 
 void Game::update(uint32_t dt) {
-  if (state != GameState::MAIN_LOOP) {
+  if (state != GameState::MAIN_LOOP || dt == 0) {
     return;
   }
-  updateAnimations(dt);
+  uint32_t before = time_;
+  time_ += dt;
+  // Only the clock moves; the map is untouched, so animation costs nothing
+  // per tile and never unshares a chunk from the history. The revision
+  // still changes whenever some object's frame would.
+  for (size_t obj = 0; obj < OBJECT_COUNT; ++obj) {
+    Object object = static_cast<Object>(obj);
+    if (object_frame_steps(object, before) !=
+        object_frame_steps(object, time_)) {
+      ++revision_;
+      break;
+    }
+  }
 }
 
-void Game::updateAnimations(uint32_t dt) {
-  for (auto& row : map) {
-    for (Tile& tile : row) {
-      tile.obj_frame_time += dt;
-      uint32_t frame_duration = object_frame_duration(tile.obj, tile.obj_frame);
-      if (tile.obj_frame_time >= frame_duration) {
-        tile.obj_frame_time -= frame_duration;
-        tile.obj_frame = object_next_frame(tile.obj, tile.obj_frame);
-      }
-    }
+int Game::objectFrame(const Tile& tile) const {
+  int count = object_frame_count(tile.obj());
+  if (count == 0) {
+    return 0;
   }
+  return (tile.objPhase() + object_frame_steps(tile.obj(), time_)) % count;
 }
 
 void Game::primaryAction() {}
 
-std::optional<Tile> Game::activeTile() const {
+const Tile* Game::activeTile() const {
   if (!hoveredTile) {
-    return std::nullopt;
+    return nullptr;
   }
   Hex3 hex = hoveredTile.value();
   if (!validTile(hex)) {
-    return std::nullopt;
+    return nullptr;
   }
-  Tile tile = map.at(hex.q).at(hex.r);
-  if (tile.type == TileType::NONE) {
-    return std::nullopt;
+  const Tile& tile = map.at(hex.q, hex.r);
+  if (tile.type() == TileType::NONE) {
+    return nullptr;
   }
-  return tile;
+  return &tile;
 }
 
 Card& Game::activeCard() {
@@ -127,10 +137,221 @@ bool Game::isAffected(Hex3 hex) const {
 }
 
 bool Game::validTile(Hex3 hex) const {
-  return hex.q >= 0 && hex.r >= 0 && hex.q < static_cast<int>(map.size()) &&
-         hex.r < static_cast<int>(map.at(0).size());
+  return shape_contains(map.width(), shape_, hex.q, hex.r);
+}
+
+void Game::placeObject(Hex3 hex, Object obj, int frame) {
+  Tile& tile = map.edit(hex.q, hex.r);
+  hash_ ^= tile_key(hex.q, hex.r, tile);
+  summary_.objectChanged(hex, tile.obj(), obj);
+  tile.setObj(obj);
+  // Pick the phase that shows `frame` right now.
+  int count = object_frame_count(obj);
+  if (count > 0) {
+    int steps = object_frame_steps(obj, time_) % count;
+    tile.setObjPhase((frame - steps + count) % count);
+  } else {
+    tile.setObjPhase(0);
+  }
+  hash_ ^= tile_key(hex.q, hex.r, tile);
+  ++revision_;
+}
+
+uint64_t Game::revision() const {
+  return revision_;
+}
+
+const CardBook& Game::cards() const {
+  return *cards_;
+}
+
+const CardEffect& Game::effectOf(size_t card) const {
+  return cards_->effect(deck[card].id);
+}
+
+bool Game::legal(const Move& move) const {
+  bool result = false;
+  withShape([&](auto shape) { result = legalIn(shape, move); });
+  return result;
+}
+
+template <typename Shape>
+bool Game::legalIn(const Shape& shape, const Move& move) const {
+  if (move.card >= deck.size() || deck[move.card].amount <= 0 ||
+      !shape.contains(move.target.q, move.target.r)) {
+    return false;
+  }
+  const CardEffect& effect = effectOf(move.card);
+  const Tile& tile = map.at(move.target.q, move.target.r);
+  if (!(effect.targetTiles & tile_bit(tile.type())) ||
+      !(effect.targetObjects & object_bit(tile.obj()))) {
+    return false;
+  }
+  if (!effect.directional) {
+    return true;
+  }
+  // A directional play has to reach at least the first tile it points at.
+  Hex3 next = {move.target.q + move.direction.q,
+               move.target.r + move.direction.r,
+               move.target.s + move.direction.s};
+  return is_direction(move.direction) && shape.contains(next.q, next.r) &&
+         (effect.affectedTiles & tile_bit(map.at(next.q, next.r).type()));
+}
+
+void Game::legalMoves(std::vector<Move>& moves) const {
+  moves.clear();
+  for (size_t card = 0; card < deck.size(); ++card) {
+    if (deck[card].amount <= 0) {
+      continue;
+    }
+    bool directional = effectOf(card).directional;
+    withShape([&](auto shape) {
+      shape.forEachTile([&](int q, int r) {
+        Move move = {card, {q, r, -q - r}, {0, 0, 0}};
+        if (!directional) {
+          if (legalIn(shape, move)) {
+            moves.push_back(move);
+          }
+          return;
+        }
+        for (Hex3 dir : HEX_DIRECTIONS) {
+          move.direction = dir;
+          if (legalIn(shape, move)) {
+            moves.push_back(move);
+          }
+        }
+      });
+    });
+  }
+}
+
+template <typename Shape, typename F>
+void Game::forEachAffected(const Shape& shape, const Move& move, F f) const {
+  if (!legalIn(shape, move)) {
+    return;
+  }
+  const CardEffect& effect = effectOf(move.card);
+  auto visit = [this, &shape, &f, &effect](Hex3 hex) {
+    if (shape.contains(hex.q, hex.r)) {
+      const Tile& tile = map.at(hex.q, hex.r);
+      if (effect.affectedTiles & tile_bit(tile.type())) {
+        f(hex, tile);
+      }
+    }
+  };
+  Hex3 target = move.target;
+  if (effect.ray) {
+    Hex3 dir = move.direction;
+    Hex3 next = {target.q + dir.q, target.r + dir.r, target.s + dir.s};
+    while (shape.contains(next.q, next.r)) {
+      visit(next);
+      next = {next.q + dir.q, next.r + dir.r, next.s + dir.s};
+    }
+    return;
+  }
+  for (Hex3 offset : effect.offsets) {
+    visit({target.q + offset.q, target.r + offset.r, target.s + offset.s});
+  }
+}
+
+template <typename Shape>
+void Game::appendAffected(const Shape& shape, const Move& move,
+                          std::vector<Hex3>& affected) const {
+  if (move.card >= deck.size()) {
+    return;
+  }
+  uint8_t shown = effectOf(move.card).previewObjects;
+  forEachAffected(shape, move, [&affected, shown](Hex3 hex,
+                                                  const Tile& tile) {
+    if (shown & object_bit(tile.obj())) {
+      affected.push_back(hex);
+    }
+  });
+}
+
+void Game::affectedBy(const Move& move, std::vector<Hex3>& affected) const {
+  affected.clear();
+  withShape([&](auto shape) { appendAffected(shape, move, affected); });
+}
+
+void Game::affectedBy(std::span<const Move> moves, std::vector<Hex3>& affected,
+                      std::vector<size_t>& ends) const {
+  affected.clear();
+  ends.clear();
+  ends.reserve(moves.size());
+  // One shape dispatch for the whole batch.
+  withShape([&](auto shape) {
+    for (const Move& move : moves) {
+      appendAffected(shape, move, affected);
+      ends.push_back(affected.size());
+    }
+  });
+}
+
+void Game::play(const Move& move, std::default_random_engine& generator) {
+  if (!legal(move)) {
+    return;
+  }
+  const CardEffect& effect = effectOf(move.card);
+  auto apply = [this, &effect, &generator](Hex3 hex, const Tile& tile) {
+    const CardTransform& transform =
+        effect.transforms[static_cast<size_t>(tile.obj())];
+    if (!transform.active) {
+      return;
+    }
+    std::uniform_int_distribution<> distrib(0, transform.frames - 1);
+    placeObject(hex, transform.to, distrib(generator));
+  };
+  withShape([&](auto shape) { forEachAffected(shape, move, apply); });
+}
+
+const MapSummary& Game::summary() const {
+  return summary_;
+}
+
+uint64_t Game::hash() const {
+  return hash_;
+}
+
+uint64_t Game::computeHash() const {
+  uint64_t hash = 0;
+  for (int q = 0; q < map.width(); ++q) {
+    for (int r = 0; r < map.height(); ++r) {
+      hash ^= tile_key(q, r, map.at(q, r));
+    }
+  }
+  for (size_t slot = 0; slot < deck.size(); ++slot) {
+    hash ^= card_key(slot, deck[slot]);
+  }
+  return hash;
+}
+
+void Game::reportMemory(MemoryReport& report) const {
+  report.add(MemoryCategory::MAP, "map", map.memoryBytes());
+  report.add(MemoryCategory::MAP, "summary", summary_.memoryBytes());
+  report.add(MemoryCategory::MAP, "game state",
+             deck.capacity() * sizeof(Card) +
+                 (affectedTiles.capacity() + highlightedTiles.capacity()) *
+                     sizeof(Hex3));
+}
+
+Snapshot Game::snapshot() const {
+  return {.map = map, .deck = deck, .hash = hash_};
+}
+
+void Game::restore(const Snapshot& snapshot) {
+  summary_.sync(snapshot.map, map);
+  map = snapshot.map;
+  deck = snapshot.deck;
+  hash_ = snapshot.hash;
+  ++revision_;
+  affectedTiles.clear();
 }
 
-Tile& Game::tileAt(Hex3 hex) {
-  return map[hex.q][hex.r];
+void Game::replaceMap(const Grid& newMap) {
+  summary_.sync(newMap, map);
+  map = newMap;
+  hash_ = computeHash();
+  ++revision_;
+  affectedTiles.clear();
 }
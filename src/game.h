@@ -3,9 +3,15 @@
 
 #include <optional>
 #include <random>
+#include <span>
 #include <unordered_set>
 #include <vector>
 
+#include "cards.h"
+#include "grid.h"
+#include "memory.h"
+#include "summary.h"
+#include "mapgen.h"
 #include "util.h"
 
 enum class GameState {
@@ -14,65 +20,99 @@ enum class GameState {
   QUIT,
 };
 
-enum class Object {
-  NONE,
-  SHROOM,
-  SHROOMS,
-  SPORES,
-};
-
-enum class TileType {
-  NONE,
-  CONTROL,
-  GRASS,
-  LUSH_GRASS,
-  MOSS,
-  SAND,
-  TREE,
-};
-
-enum class CardType {
-  RAIN_M,
-  SPORES_M,
-  WIND_M,
-};
-
-struct Tile {
-  TileType type;
-  Object obj;
-  Hex3 coords;
-  int tile_frame;
-  int obj_frame;
-  uint32_t tile_frame_time;
-  uint32_t obj_frame_time;
-};
-
 struct Card {
-  CardType type;
+  CardId id;
   int amount;
   bool selectingOrigin;
   bool selectingDirection;
 };
 
-typedef std::vector<std::vector<Tile>> Grid;
+// A card play. For directional cards (WIND_M) the target is the origin and
+// direction is the unit hex step the effect travels in; other cards ignore
+// direction.
+struct Move {
+  size_t card;
+  Hex3 target;
+  Hex3 direction;
+};
+
+// The part of the game state that moves change; cheap to copy because the
+// grid shares its chunks.
+struct Snapshot {
+  Grid map;
+  std::vector<Card> deck;
+  uint64_t hash;
+};
 
 class Game {
  public:
-  Game();
+  explicit Game(uint32_t seed = std::default_random_engine::default_seed,
+                const MapConfig& mapConfig = {});
 
+  // Advances the game clock; object animation is derived from it.
   void update(uint32_t dt);
+  // The animation frame tile's object shows at the current game time.
+  int objectFrame(const Tile& tile) const;
 
   void primaryAction();
 
-  std::optional<Tile> activeTile() const;
+  const Tile* activeTile() const;
   Card& activeCard();
   const Card& peekActiveCard() const;
   bool isAffected(Hex3 hex) const;
+  // Inside the map's shape; tiles cut off a hexagonal map are not.
   bool validTile(Hex3 hex) const;
-  Tile& tileAt(Hex3 hex);
+  // Calls f with the map's shape, a compile-time one for the standard board
+  // (see with_shape).
+  template <typename F>
+  void withShape(F f) const {
+    with_shape(map.width(), shape_, f);
+  }
+  // Rule-level map mutation; keeps revision() and hash() current.
+  void placeObject(Hex3 hex, Object obj, int frame);
+
+  const CardBook& cards() const;
+  const CardEffect& effectOf(size_t card) const;
+
+  // Card rules are table lookups into cards(); no card is special-cased.
+  bool legal(const Move& move) const;
+  void legalMoves(std::vector<Move>& moves) const;
+  void affectedBy(const Move& move, std::vector<Hex3>& affected) const;
+  // Footprints of many moves in one pass: the tiles of moves[i] are
+  // affected[ends[i - 1], ends[i]) (from 0 for the first move).
+  void affectedBy(std::span<const Move> moves, std::vector<Hex3>& affected,
+                  std::vector<size_t>& ends) const;
+  void play(const Move& move, std::default_random_engine& generator);
+
+  // Bumped whenever the map changes, including animation frames.
+  uint64_t revision() const;
+
+  // Per-chunk terrain and object counts, kept current with the map.
+  const MapSummary& summary() const;
+
+  // Zobrist hash of tile types, objects and the deck, maintained
+  // incrementally. Animation state is not part of it.
+  uint64_t hash() const;
+  // Full recompute of hash(), for verifying the incremental one.
+  uint64_t computeHash() const;
+
+  void reportMemory(MemoryReport& report) const;
+
+  Snapshot snapshot() const;
+  void restore(const Snapshot& snapshot);
+  // Replaces the map wholesale, e.g. with one received over the network,
+  // and rebuilds everything derived from it. Set the deck first; it is part
+  // of the hash.
+  void replaceMap(const Grid& newMap);
 
  private:
-  void updateAnimations(uint32_t dt);
+  template <typename Shape>
+  bool legalIn(const Shape& shape, const Move& move) const;
+  template <typename Shape, typename F>
+  void forEachAffected(const Shape& shape, const Move& move, F f) const;
+  template <typename Shape>
+  void appendAffected(const Shape& shape, const Move& move,
+                      std::vector<Hex3>& affected) const;
 
  public:
   GameState state = GameState::MENU;
@@ -89,7 +129,13 @@ class Game {
   std::vector<Card> deck;
 
  private:
+  MapShape shape_;
+  const CardBook* cards_;
+  // Game clock in milliseconds, advanced by update().
   uint32_t time_;
+  uint64_t revision_;
+  uint64_t hash_;
+  MapSummary summary_;
 
   std::default_random_engine generator_;
 };
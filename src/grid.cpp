@@ -0,0 +1,94 @@
+#include "grid.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+
+namespace {
+constexpr size_t PARALLEL_ALLOCATION_CHUNKS = 1024;
+
+int tile_index(int q, int r) {
+  return (q % CHUNK_SIZE) * CHUNK_SIZE + (r % CHUNK_SIZE);
+}
+}  // namespace
+
+Grid::Grid()
+    : Grid(0, 0) {}
+
+Grid::Grid(int width, int height)
+    : width_(width)
+    , height_(height)
+    , chunk_rows_((height + CHUNK_SIZE - 1) / CHUNK_SIZE) {
+  chunks_.resize(chunkColumns() * chunk_rows_);
+  // Zeroing the chunks of a very large map dominates its generation time,
+  // so the chunks are allocated (and first touched) in parallel.
+  auto allocate = [this](size_t i) { chunks_[i] = std::make_shared<Chunk>(); };
+  if (chunks_.size() >= PARALLEL_ALLOCATION_CHUNKS) {
+    parallel_for(chunks_.size(), allocate);
+  } else {
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      allocate(i);
+    }
+  }
+}
+
+int Grid::width() const {
+  return width_;
+}
+
+int Grid::height() const {
+  return height_;
+}
+
+bool Grid::contains(int q, int r) const {
+  return q >= 0 && r >= 0 && q < width_ && r < height_;
+}
+
+const Tile& Grid::at(int q, int r) const {
+  return chunks_[chunkIndex(q, r)]->tiles[tile_index(q, r)];
+}
+
+Tile& Grid::edit(int q, int r) {
+  std::shared_ptr<Chunk>& chunk = chunks_[chunkIndex(q, r)];
+  if (chunk.use_count() > 1) {
+    chunk = std::make_shared<Chunk>(*chunk);
+  }
+  return chunk->tiles[tile_index(q, r)];
+}
+
+size_t Grid::chunkCount() const {
+  return chunks_.size();
+}
+
+int Grid::chunkColumns() const {
+  return (width_ + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+int Grid::chunkRows() const {
+  return chunk_rows_;
+}
+
+bool Grid::sharesChunk(const Grid& other, size_t chunk) const {
+  return chunk < chunks_.size() && chunk < other.chunks_.size() &&
+         chunks_[chunk] == other.chunks_[chunk];
+}
+
+size_t Grid::memoryBytes() const {
+  return chunks_.capacity() * sizeof(chunks_[0]) +
+         chunks_.size() * sizeof(Chunk);
+}
+
+size_t Grid::memoryBytes(const Grid& base) const {
+  size_t bytes = chunks_.capacity() * sizeof(chunks_[0]);
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    if (i < base.chunks_.size() && chunks_[i] == base.chunks_[i]) {
+      continue;
+    }
+    bytes += sizeof(Chunk) / std::max<long>(chunks_[i].use_count(), 1);
+  }
+  return bytes;
+}
+
+size_t Grid::chunkIndex(int q, int r) const {
+  return (q / CHUNK_SIZE) * chunk_rows_ + (r / CHUNK_SIZE);
+}
@@ -0,0 +1,131 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "data.h"
+
+enum class Object {
+  NONE,
+  SHROOM,
+  SHROOMS,
+  SPORES,
+};
+
+enum class TileType {
+  NONE,
+  CONTROL,
+  GRASS,
+  LUSH_GRASS,
+  MOSS,
+  SAND,
+  TREE,
+};
+
+constexpr size_t TILE_TYPE_COUNT = 7;
+constexpr size_t OBJECT_COUNT = 4;
+
+// A map cell packed into two bytes: terrain and object share one byte, the
+// terrain animation frame and the object animation phase share the other.
+// Object animation runs off the game clock (see Game::objectFrame), so a
+// tile holds no timer and animating never edits the map. The coordinates
+// are implied by the tile's position in the grid.
+class Tile {
+ public:
+  TileType type() const {
+    return static_cast<TileType>(kind_ & 0x0f);
+  }
+  void setType(TileType type) {
+    kind_ = (kind_ & 0xf0) | static_cast<uint8_t>(type);
+  }
+
+  Object obj() const {
+    return static_cast<Object>(kind_ >> 4);
+  }
+  void setObj(Object obj) {
+    kind_ = (kind_ & 0x0f) | (static_cast<uint8_t>(obj) << 4);
+  }
+
+  int tileFrame() const {
+    return frames_ & 0x0f;
+  }
+  void setTileFrame(int frame) {
+    frames_ = (frames_ & 0xf0) | (frame & 0x0f);
+  }
+
+  // The object's animation frame at game time 0.
+  int objPhase() const {
+    return frames_ >> 4;
+  }
+  void setObjPhase(int phase) {
+    frames_ = (frames_ & 0x0f) | ((phase & 0x0f) << 4);
+  }
+
+  bool operator==(const Tile& other) const = default;
+
+ private:
+  uint8_t kind_;
+  uint8_t frames_;
+};
+
+static_assert(sizeof(Tile) == 2);
+
+constexpr int CHUNK_SIZE = 16;
+
+// Tile storage split into CHUNK_SIZE x CHUNK_SIZE chunks that are shared
+// between copies of the grid. Copying a grid only copies the chunk pointers;
+// a chunk is duplicated the first time it is edited while shared.
+class Grid {
+ public:
+  Grid();
+  Grid(int width, int height);
+
+  int width() const;
+  int height() const;
+  bool contains(int q, int r) const;
+
+  const Tile& at(int q, int r) const;
+  Tile& edit(int q, int r);
+
+  size_t chunkCount() const;
+  int chunkColumns() const;
+  int chunkRows() const;
+  // Chunk i holds tiles [column * CHUNK_SIZE, +CHUNK_SIZE) x
+  // [row * CHUNK_SIZE, +CHUNK_SIZE) with i = column * chunkRows() + row.
+  // Grids that share a chunk are guaranteed to have the same tiles in it.
+  bool sharesChunk(const Grid& other, size_t chunk) const;
+  // Chunk storage referenced by this grid, shared or not.
+  size_t memoryBytes() const;
+  // Storage this grid holds on top of base (e.g. a snapshot of the live
+  // map). Chunks it shares with base cost nothing; chunks shared only with
+  // other grids are split evenly between them, so summing this over all
+  // snapshots of base counts every chunk once.
+  size_t memoryBytes(const Grid& base) const;
+
+  template <typename F>
+  void forEach(F f) const {
+    for (int q = 0; q < width_; ++q) {
+      for (int r = 0; r < height_; ++r) {
+        f(at(q, r));
+      }
+    }
+  }
+
+ private:
+  struct Chunk {
+    std::array<Tile, CHUNK_SIZE * CHUNK_SIZE> tiles;
+  };
+
+  size_t chunkIndex(int q, int r) const;
+
+ private:
+  int width_;
+  int height_;
+  int chunk_rows_;
+  std::vector<std::shared_ptr<Chunk>> chunks_;
+};
+
+#endif  // GRID_H
@@ -0,0 +1,64 @@
+#include "history.h"
+
+namespace {
+template <typename Stack>
+size_t stack_bytes(const Stack& stack, const Grid& live) {
+  size_t bytes = 0;
+  for (const Snapshot& snapshot : stack) {
+    bytes += sizeof(Snapshot) + snapshot.map.memoryBytes(live) +
+             snapshot.deck.capacity() * sizeof(Card);
+  }
+  return bytes;
+}
+}  // namespace
+
+History::History(size_t capacity)
+    : capacity_(capacity) {}
+
+void History::record(const Game& game) {
+  undo_.push_back(game.snapshot());
+  if (undo_.size() > capacity_) {
+    undo_.pop_front();
+  }
+  redo_.clear();
+}
+
+bool History::undo(Game& game) {
+  if (undo_.empty()) {
+    return false;
+  }
+  redo_.push_back(game.snapshot());
+  game.restore(undo_.back());
+  undo_.pop_back();
+  return true;
+}
+
+bool History::redo(Game& game) {
+  if (redo_.empty()) {
+    return false;
+  }
+  undo_.push_back(game.snapshot());
+  game.restore(redo_.back());
+  redo_.pop_back();
+  return true;
+}
+
+bool History::canUndo() const {
+  return !undo_.empty();
+}
+
+bool History::canRedo() const {
+  return !redo_.empty();
+}
+
+void History::clear() {
+  undo_.clear();
+  redo_.clear();
+}
+
+void History::reportMemory(MemoryReport& report, const Grid& live) const {
+  report.add(MemoryCategory::HISTORY, "undo", stack_bytes(undo_, live));
+  report.add(MemoryCategory::HISTORY, "redo",
+             stack_bytes(redo_, live) +
+                 (redo_.capacity() - redo_.size()) * sizeof(Snapshot));
+}
@@ -0,0 +1,35 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "game.h"
+
+constexpr size_t HISTORY_CAPACITY = 256;
+
+// Undo/redo stacks of game snapshots. Snapshots share unchanged map chunks,
+// so each entry costs one pointer per chunk plus the chunks a move touched.
+class History {
+ public:
+  explicit History(size_t capacity = HISTORY_CAPACITY);
+
+  void record(const Game& game);
+  bool undo(Game& game);
+  bool redo(Game& game);
+
+  bool canUndo() const;
+  bool canRedo() const;
+  void clear();
+
+  // Counts snapshot storage not shared with the live map.
+  void reportMemory(MemoryReport& report, const Grid& live) const;
+
+ private:
+  size_t capacity_;
+  std::deque<Snapshot> undo_;
+  std::vector<Snapshot> redo_;
+};
+
+#endif  // HISTORY_H
@@ -0,0 +1,114 @@
+#include "journal.h"
+
+#include <cstring>
+
+namespace {
+constexpr char MAGIC[8] = {'F', 'U', 'N', 'G', 'I', 'J', 'N', 'L'};
+constexpr uint32_t VERSION = 4;
+constexpr size_t FLUSH_INTERVAL = 60;
+
+struct FrameRecord {
+  uint32_t dt;
+  int32_t x, y;
+  int32_t button;
+  int32_t command;
+};
+
+template <typename T>
+void write_raw(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_raw(std::ifstream& in, T& value) {
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return in.gcount() == sizeof(T);
+}
+}  // namespace
+
+JournalWriter::JournalWriter(const std::string& path, JournalHeader header)
+    : out_(path, std::ios::binary | std::ios::trunc)
+    , unflushed_(0) {
+  out_.write(MAGIC, sizeof(MAGIC));
+  write_raw(out_, VERSION);
+  write_raw(out_, header.gameSeed);
+  write_raw(out_, header.controllerSeed);
+  write_raw(out_, static_cast<int32_t>(header.mapConfig.size));
+  write_raw(out_, static_cast<int32_t>(header.mapConfig.shape));
+  out_.flush();
+}
+
+bool JournalWriter::good() const {
+  return out_.good();
+}
+
+void JournalWriter::record(const InputFrame& frame) {
+  FrameRecord record = {
+      .dt = frame.dt,
+      .x = frame.mousePos.x,
+      .y = frame.mousePos.y,
+      .button = frame.mouseButton,
+      .command = static_cast<int32_t>(frame.command),
+  };
+  write_raw(out_, record);
+  if (++unflushed_ >= FLUSH_INTERVAL) {
+    flush();
+  }
+}
+
+void JournalWriter::flush() {
+  out_.flush();
+  unflushed_ = 0;
+}
+
+std::optional<Journal> Journal::load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return std::nullopt;
+  }
+  char magic[sizeof(MAGIC)];
+  in.read(magic, sizeof(magic));
+  uint32_t version = 0;
+  if (in.gcount() != sizeof(magic) ||
+      std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      !read_raw(in, version) || version != VERSION) {
+    return std::nullopt;
+  }
+
+  Journal journal;
+  int32_t mapSize = 0;
+  int32_t mapShape = 0;
+  if (!read_raw(in, journal.header_.gameSeed) ||
+      !read_raw(in, journal.header_.controllerSeed) ||
+      !read_raw(in, mapSize) || !read_raw(in, mapShape) || mapSize < 3 ||
+      mapSize > MAX_MAP_SIZE || mapShape < 0 ||
+      mapShape > static_cast<int32_t>(MapShape::PARALLELOGRAM)) {
+    return std::nullopt;
+  }
+  journal.header_.mapConfig.size = mapSize;
+  journal.header_.mapConfig.shape = static_cast<MapShape>(mapShape);
+  FrameRecord record;
+  // A truncated trailing record (e.g. after a crash) is silently dropped.
+  while (read_raw(in, record)) {
+    journal.frames_.push_back({
+        .dt = record.dt,
+        .mousePos = {record.x, record.y},
+        .mouseButton = record.button,
+        .command = static_cast<InputCommand>(record.command),
+        .timestamp = 0,
+    });
+  }
+  return journal;
+}
+
+const JournalHeader& Journal::header() const {
+  return header_;
+}
+
+size_t Journal::size() const {
+  return frames_.size();
+}
+
+const InputFrame& Journal::at(size_t tick) const {
+  return frames_[tick];
+}
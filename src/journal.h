@@ -0,0 +1,46 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "controller.h"
+
+struct JournalHeader {
+  uint32_t gameSeed;
+  uint32_t controllerSeed;
+  MapConfig mapConfig;
+};
+
+// Streams every tick's input to disk as it happens so that a session can be
+// reproduced even if the process does not exit cleanly.
+class JournalWriter {
+ public:
+  JournalWriter(const std::string& path, JournalHeader header);
+
+  bool good() const;
+  void record(const InputFrame& frame);
+  void flush();
+
+ private:
+  std::ofstream out_;
+  size_t unflushed_;
+};
+
+class Journal {
+ public:
+  static std::optional<Journal> load(const std::string& path);
+
+  const JournalHeader& header() const;
+  size_t size() const;
+  const InputFrame& at(size_t tick) const;
+
+ private:
+  JournalHeader header_;
+  std::vector<InputFrame> frames_;
+};
+
+#endif  // JOURNAL_H
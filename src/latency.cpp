@@ -0,0 +1,49 @@
+#include "latency.h"
+
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram() {
+  clear();
+}
+
+void LatencyHistogram::add(double ms) {
+  int index = std::clamp(static_cast<int>(ms / LATENCY_BUCKET_MS), 0,
+                         LATENCY_BUCKETS - 1);
+  ++buckets_[index];
+  ++count_;
+  max_ = std::max(max_, ms);
+}
+
+void LatencyHistogram::clear() {
+  buckets_.fill(0);
+  count_ = 0;
+  max_ = 0;
+}
+
+uint64_t LatencyHistogram::count() const {
+  return count_;
+}
+
+uint64_t LatencyHistogram::bucket(int index) const {
+  return buckets_[index];
+}
+
+uint64_t LatencyHistogram::peak() const {
+  return *std::max_element(buckets_.begin(), buckets_.end());
+}
+
+double LatencyHistogram::max() const {
+  return max_;
+}
+
+double LatencyHistogram::percentile(double fraction) const {
+  uint64_t target = static_cast<uint64_t>(fraction * count_);
+  uint64_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen > target) {
+      return (i + 1) * LATENCY_BUCKET_MS;
+    }
+  }
+  return max_;
+}
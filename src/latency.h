@@ -0,0 +1,32 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <array>
+#include <cstdint>
+
+// Histogram of input-to-present latencies in LATENCY_BUCKET_MS wide
+// buckets; the last bucket collects everything beyond the range.
+constexpr int LATENCY_BUCKETS = 50;
+constexpr double LATENCY_BUCKET_MS = 2;
+
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void add(double ms);
+  void clear();
+
+  uint64_t count() const;
+  uint64_t bucket(int index) const;
+  uint64_t peak() const;
+  double max() const;
+  // Upper edge of the bucket containing the given fraction of samples.
+  double percentile(double fraction) const;
+
+ private:
+  std::array<uint64_t, LATENCY_BUCKETS> buckets_;
+  uint64_t count_;
+  double max_;
+};
+
+#endif  // LATENCY_H
@@ -4,13 +4,32 @@
 #include <allegro5/allegro_primitives.h>
 #include <allegro5/allegro_ttf.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
 #include <iostream>
 #include <memory>
-#include <unordered_set>
-
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "alloc_stats.h"
+#include "arena.h"
+#include "capture.h"
 #include "controller.h"
+#include "distance.h"
 #include "game.h"
+#include "journal.h"
+#include "latency.h"
+#include "memory.h"
+#include "present.h"
 #include "renderer.h"
+#include "replay.h"
+#include "search.h"
+#include "session.h"
+#include "text.h"
 
 constexpr int RENDER_WIDTH = 400;
 constexpr int RENDER_HEIGHT = 300;
@@ -20,7 +39,437 @@ constexpr int FONT_SIZE = 18;
 
 constexpr ALLEGRO_COLOR DEBUG_COLOR = {0.0, 1.0, 0.2, 1};
 
+constexpr int LATENCY_GRAPH_HEIGHT = 60;
+
+void draw_latency_histogram(const LatencyHistogram& histogram, int x, int y) {
+  uint64_t peak = std::max<uint64_t>(histogram.peak(), 1);
+  for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+    float height = LATENCY_GRAPH_HEIGHT * histogram.bucket(i) / peak;
+    al_draw_filled_rectangle(x + i * 6, y + LATENCY_GRAPH_HEIGHT - height,
+                             x + i * 6 + 5, y + LATENCY_GRAPH_HEIGHT,
+                             DEBUG_COLOR);
+  }
+}
+
+struct Options {
+  std::string recordPath;
+  std::string replayPath;
+  std::optional<size_t> seekTick;
+  std::optional<int> searchBudget;
+  // Players in a local lockstep session test.
+  std::optional<int> loopbackPlayers;
+  std::string sessionAddress = "unix:/tmp/fungi-session.sock";
+  std::string capturePath;
+  CaptureFormat captureFormat = CaptureFormat::PNG;
+  MapConfig mapConfig;
+  bool mapgenBenchmark = false;
+  bool distanceBenchmark = false;
+  bool assertNoAlloc = false;
+  // Checks the incremental game hash against a full recompute every tick.
+  bool verifyHash = false;
+  bool lowLatency = false;
+  // 0 fits the largest integer scale into the window.
+  int renderScale = 0;
+  PresentMode presentMode = PresentMode::GPU;
+};
+
+constexpr std::chrono::milliseconds HINT_BUDGET{50};
+constexpr size_t FRAME_ARENA_SIZE = 64 * 1024;
+// Frames before this one may still be growing containers and the arena.
+constexpr int ALLOCATION_WARMUP_FRAMES = 120;
+// Walking the history for the memory report is not free; the overlay only
+// refreshes it this often.
+constexpr int MEMORY_REFRESH_FRAMES = 60;
+constexpr int MENU_FONT_SIZE = 30;
+// Where the controller is told the mouse is while the view is zoomed out,
+// well away from the grid and the cards.
+constexpr Vec2i OFF_GRID = {.x = -1000, .y = -1000};
+
+Options parse_options(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      options.recordPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      options.replayPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+      options.seekTick = std::stoul(argv[++i]);
+    } else if (std::strcmp(argv[i], "--map-size") == 0 && i + 1 < argc) {
+      options.mapConfig.size =
+          std::clamp(std::stoi(argv[++i]), 3, MAX_MAP_SIZE);
+    } else if (std::strcmp(argv[i], "--map-shape") == 0 && i + 1 < argc) {
+      ++i;
+      options.mapConfig.shape = std::strcmp(argv[i], "parallelogram") == 0
+                                    ? MapShape::PARALLELOGRAM
+                                    : MapShape::HEXAGON;
+    } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+      options.renderScale = std::max(0, std::stoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--present") == 0 && i + 1 < argc) {
+      options.presentMode = std::strcmp(argv[++i], "cpu") == 0
+                                ? PresentMode::CPU
+                                : PresentMode::GPU;
+    } else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+      options.capturePath = argv[++i];
+    } else if (std::strcmp(argv[i], "--capture-format") == 0 &&
+               i + 1 < argc) {
+      options.captureFormat = std::strcmp(argv[++i], "raw") == 0
+                                  ? CaptureFormat::RAW
+                                  : CaptureFormat::PNG;
+    } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+      options.lowLatency = true;
+    } else if (std::strcmp(argv[i], "--assert-no-alloc") == 0) {
+      options.assertNoAlloc = true;
+    } else if (std::strcmp(argv[i], "--verify-hash") == 0) {
+      options.verifyHash = true;
+    } else if (std::strcmp(argv[i], "--mapgen") == 0) {
+      options.mapgenBenchmark = true;
+    } else if (std::strcmp(argv[i], "--distance") == 0) {
+      options.distanceBenchmark = true;
+    } else if (std::strcmp(argv[i], "--search") == 0 && i + 1 < argc) {
+      options.searchBudget = std::stoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--loopback") == 0 && i + 1 < argc) {
+      options.loopbackPlayers = std::max(1, std::stoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--session") == 0 && i + 1 < argc) {
+      options.sessionAddress = argv[++i];
+    } else {
+      std::cerr << "Unknown argument [" << argv[i] << "]" << std::endl;
+    }
+  }
+  return options;
+}
+
+// Draws every tick of a replay, from --seek if given, and records it. There
+// is no display: the frame and textures are memory bitmaps drawn in
+// software. The encoder sets the pace, so no frame is dropped.
+int run_replay_capture(const Options& options, Replay& replay) {
+  al_init();
+  al_init_primitives_addon();
+  al_init_ttf_addon();
+  al_init_image_addon();
+  al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+  Renderer renderer(RENDER_WIDTH, RENDER_HEIGHT);
+  renderer.init(replay.game().cards());
+  auto capture = std::make_unique<FrameCapture>(
+      options.capturePath, options.captureFormat, RENDER_WIDTH,
+      RENDER_HEIGHT);
+  if (!capture->good()) {
+    std::cerr << "Failed to open capture [" << options.capturePath << "]"
+              << std::endl;
+    return 1;
+  }
+  if (options.seekTick) {
+    replay.seek(*options.seekTick);
+  }
+
+  FrameArena arena(FRAME_ARENA_SIZE);
+  View view = {.zoomOut = 0,
+               .center = Vec2{.x = RENDER_WIDTH / 2.f,
+                              .y = RENDER_HEIGHT / 2.f} -
+                         GRID_ORIGIN};
+  auto start = std::chrono::steady_clock::now();
+  size_t first = replay.tick();
+  std::optional<uint64_t> lastSignature;
+  while (!replay.done()) {
+    replay.step();
+    const Game& game = replay.game();
+    Vec2i cursor = replay.controller().mousePos;
+    uint64_t signature = renderer.signature(game, view, cursor);
+    capture->waitForRoom();
+    if (signature == lastSignature) {
+      capture->repeat();
+      continue;
+    }
+    arena.reset();
+    renderer.draw(game, view, cursor, arena);
+    capture->capture(renderer.frame());
+    lastSignature = signature;
+  }
+  CaptureStats captured = capture->stats();
+  // Waits for the encoder to write out the queued frames.
+  capture.reset();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Captured ticks " << first << " to " << replay.tick()
+            << ": " << captured.frames << " frames, " << captured.dropped
+            << " dropped in " << elapsed.count() * 1000 << " ms"
+            << std::endl;
+  return 0;
+}
+
+int run_replay(const Options& options) {
+  auto journal = Journal::load(options.replayPath);
+  if (!journal) {
+    std::cerr << "Failed to load journal [" << options.replayPath << "]"
+              << std::endl;
+    return 1;
+  }
+  // Construction generates the map, so it is part of the timed run.
+  auto start = std::chrono::steady_clock::now();
+  Replay replay(*journal);
+  if (!options.capturePath.empty()) {
+    return run_replay_capture(options, replay);
+  }
+  if (options.verifyHash) {
+    size_t end = options.seekTick.value_or(journal->size());
+    while (!replay.done() && replay.tick() < end) {
+      replay.step();
+      if (replay.game().hash() != replay.game().computeHash()) {
+        std::cerr << "Hash mismatch at tick " << replay.tick() << std::endl;
+        return 1;
+      }
+    }
+  } else if (options.seekTick) {
+    replay.seek(*options.seekTick);
+  } else {
+    replay.runToEnd();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Replayed " << replay.tick() << " / " << journal->size()
+            << " ticks in " << elapsed.count() * 1000 << " ms ("
+            << replay.tick() / std::max(elapsed.count(), 1e-9)
+            << " ticks/s)" << std::endl;
+  std::cout << "State hash " << std::hex << replay.game().hash() << std::dec
+            << std::endl;
+  return 0;
+}
+
+int run_mapgen(const Options& options) {
+  auto start = std::chrono::steady_clock::now();
+  Grid map = generate_map(options.mapConfig, 0);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  size_t counts[static_cast<int>(TileType::TREE) + 1] = {};
+  map.forEach([&counts](const Tile& tile) {
+    ++counts[static_cast<int>(tile.type())];
+  });
+  std::cout << "Generated " << map.width() << "x" << map.height() << " in "
+            << elapsed.count() * 1000 << " ms, " << map.memoryBytes()
+            << " bytes" << std::endl;
+  const char* names[] = {"none",  "control", "grass", "lush grass",
+                         "moss", "sand",    "tree"};
+  for (size_t i = 0; i < std::size(counts); ++i) {
+    std::cout << "  " << names[i] << ": " << counts[i] << std::endl;
+  }
+  return 0;
+}
+
+// Times a full shroom distance field and incremental repairs after random
+// shroom placements and removals, then checks the result against a rebuild.
+int run_distance(const Options& options) {
+  constexpr int TOGGLES = 1000;
+  Game game(std::default_random_engine::default_seed, options.mapConfig);
+  DistanceField field(SHROOM_DISTANCE);
+  auto start = std::chrono::steady_clock::now();
+  field.compute(game.map, options.mapConfig.threads);
+  std::chrono::duration<double> full =
+      std::chrono::steady_clock::now() - start;
+
+  std::default_random_engine generator;
+  std::uniform_int_distribution<> pickQ(0, game.map.width() - 1);
+  std::uniform_int_distribution<> pickR(0, game.map.height() - 1);
+  std::chrono::duration<double> updates{0};
+  for (int i = 0; i < TOGGLES; ++i) {
+    Hex3 hex = {pickQ(generator), pickR(generator), 0};
+    hex.s = -hex.q - hex.r;
+    const Tile& tile = game.map.at(hex.q, hex.r);
+    if (tile.type() == TileType::NONE) {
+      continue;
+    }
+    game.placeObject(
+        hex, tile.obj() == Object::SHROOM ? Object::NONE : Object::SHROOM, 0);
+    start = std::chrono::steady_clock::now();
+    field.update(game.map, hex);
+    updates += std::chrono::steady_clock::now() - start;
+  }
+
+  DistanceField rebuilt(SHROOM_DISTANCE);
+  rebuilt.compute(game.map, options.mapConfig.threads);
+  for (int q = 0; q < game.map.width(); ++q) {
+    for (int r = 0; r < game.map.height(); ++r) {
+      if (field.at(q, r) != rebuilt.at(q, r)) {
+        std::cerr << "Distance mismatch at " << q << ", " << r << std::endl;
+        return 1;
+      }
+    }
+  }
+  std::cout << "Distance field " << game.map.width() << "x"
+            << game.map.height() << " in " << full.count() * 1000
+            << " ms, update " << updates.count() * 1e6 / TOGGLES << " us"
+            << std::endl;
+  return 0;
+}
+
+int run_search(const Options& options) {
+  Game game(std::default_random_engine::default_seed, options.mapConfig);
+  game.state = GameState::MAIN_LOOP;
+  SearchConfig config;
+  config.budget = std::chrono::milliseconds(*options.searchBudget);
+  SearchResult result = search(game, config);
+  std::cout << "Searched " << result.rollouts << " rollouts in "
+            << result.seconds * 1000 << " ms ("
+            << result.rollouts / std::max(result.seconds, 1e-9)
+            << " rollouts/s)" << std::endl;
+  for (size_t i = 0; i < std::min<size_t>(result.moves.size(), 5); ++i) {
+    const RankedMove& ranked = result.moves[i];
+    std::cout << "  card " << ranked.move.card << " at ["
+              << ranked.move.target.q << ", " << ranked.move.target.r
+              << "] score " << ranked.meanScore << " (" << ranked.rollouts
+              << " rollouts)" << std::endl;
+  }
+  return 0;
+}
+
+struct LoopbackClient {
+  SessionStats stats = {0, 0, 0};
+  size_t welcomeBytes = 0;
+  uint64_t hash = 0;
+  bool desynced = false;
+  std::vector<double> tickMs;
+};
+
+// Plays one client of a loopback session until the host's last tick.
+// Every few ticks a player tries a few random moves and sends the first
+// legal one; listing all legal moves would scan the whole map and the
+// latency figures would measure that instead of the session.
+void run_loopback_client(const std::string& address, int seed,
+                         bool spectator, uint64_t ticks,
+                         LoopbackClient& result) {
+  constexpr int MOVE_ONE_IN = 8;
+  constexpr int MOVE_ATTEMPTS = 16;
+  SessionClient client(address, spectator);
+  if (!client.good()) {
+    return;
+  }
+  result.welcomeBytes = client.welcomeBytes();
+  std::default_random_engine generator(seed);
+  const Game& game = client.game();
+  std::uniform_int_distribution<> pickQ(0, game.map.width() - 1);
+  std::uniform_int_distribution<> pickR(0, game.map.height() - 1);
+  while (client.tick() < ticks) {
+    std::optional<Move> move;
+    bool tryMove = !spectator && generator() % MOVE_ONE_IN == 0;
+    for (int i = 0; tryMove && i < MOVE_ATTEMPTS && !move; ++i) {
+      int q = pickQ(generator);
+      int r = pickR(generator);
+      Hex3 direction = HEX_DIRECTIONS[generator() % std::size(HEX_DIRECTIONS)];
+      Move attempt = {.card = generator() % game.deck.size(),
+                      .target = {q, r, -q - r},
+                      .direction = direction};
+      if (game.legal(attempt)) {
+        move = attempt;
+      }
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!client.step(move)) {
+      break;
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    result.tickMs.push_back(elapsed.count() * 1000);
+  }
+  result.stats = client.stats();
+  result.hash = client.game().hash();
+  result.desynced = client.desynced();
+}
+
+// Runs a session host and its players as threads talking over a real
+// socket, with a spectator joining halfway through, then checks every peer
+// ended in the host's state and reports per-tick bandwidth, the late join
+// cost and the time from sending a command to applying its tick.
+int run_loopback(const Options& options) {
+  constexpr uint64_t TICKS = 600;
+  constexpr int CONNECT_TIMEOUT_MS = 5000;
+  int players = *options.loopbackPlayers;
+  SessionConfig config = {
+      .seed = 1, .mapConfig = options.mapConfig, .players = players};
+  SessionHost host(config, options.sessionAddress);
+  if (!host.good()) {
+    return 1;
+  }
+
+  // The last one is the spectator.
+  std::vector<LoopbackClient> clients(players + 1);
+  std::vector<std::thread> threads;
+  auto connect = [&](int i) {
+    threads.emplace_back(run_loopback_client, options.sessionAddress, i,
+                         i == players, TICKS, std::ref(clients[i]));
+    if (!host.admit(CONNECT_TIMEOUT_MS)) {
+      std::cerr << "Client " << i << " did not connect" << std::endl;
+    }
+  };
+  for (int i = 0; i < players; ++i) {
+    connect(i);
+  }
+  while (host.tick() < TICKS / 2 && host.step()) {
+  }
+  connect(players);
+  while (host.tick() < TICKS && host.step()) {
+  }
+  // Unblocks any client still waiting on a tick that will not come.
+  host.close();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  uint64_t hostHash = host.game().hash();
+  bool synced = host.tick() == TICKS;
+  std::vector<double> tickMs;
+  double down = 0, up = 0;
+  for (int i = 0; i <= players; ++i) {
+    const LoopbackClient& client = clients[i];
+    if (client.stats.ticks != TICKS || client.hash != hostHash ||
+        client.desynced) {
+      std::cerr << "Client " << i << " out of sync at tick "
+                << client.stats.ticks << std::endl;
+      synced = false;
+    }
+    if (i < players) {
+      tickMs.insert(tickMs.end(), client.tickMs.begin(), client.tickMs.end());
+      down += client.stats.bytesReceived - client.welcomeBytes;
+      up += client.stats.bytesSent;
+    }
+  }
+  std::sort(tickMs.begin(), tickMs.end());
+  auto percentile = [&tickMs](double fraction) {
+    return tickMs.empty() ? 0 : tickMs[(tickMs.size() - 1) * fraction];
+  };
+  double perTick = 1.0 / (TICKS * players);
+  std::cout << players << " players, " << host.game().map.width() << "x"
+            << host.game().map.height() << " map, " << TICKS << " ticks"
+            << std::endl;
+  std::cout << "  per player per tick: " << down * perTick << " bytes down, "
+            << up * perTick << " bytes up" << std::endl;
+  std::cout << "  spectator join at tick " << TICKS / 2 << ": "
+            << clients[players].welcomeBytes << " bytes (full map "
+            << host.game().map.width() * host.game().map.height() *
+                   sizeof(Tile)
+            << ")" << std::endl;
+  std::cout << "  tick latency: p50 " << percentile(0.5) * 1000 << " us, p99 "
+            << percentile(0.99) * 1000 << " us, max "
+            << percentile(1) * 1000 << " us" << std::endl;
+  return synced ? 0 : 1;
+}
+
 int real_main(int argc, char** argv) {
+  Options options = parse_options(argc, argv);
+  if (!options.replayPath.empty()) {
+    return run_replay(options);
+  }
+  if (options.searchBudget) {
+    return run_search(options);
+  }
+  if (options.mapgenBenchmark) {
+    return run_mapgen(options);
+  }
+  if (options.distanceBenchmark) {
+    return run_distance(options);
+  }
+  if (options.loopbackPlayers) {
+    return run_loopback(options);
+  }
+
   al_init();
   al_install_keyboard();
   al_install_mouse();
@@ -28,9 +477,11 @@ int real_main(int argc, char** argv) {
   ALLEGRO_TIMER* timer = al_create_timer(1.0 / 60.0);
   ALLEGRO_EVENT_QUEUE* queue = al_create_event_queue();
 
-  // al_set_new_display_flags(ALLEGRO_RESIZABLE);
-  ALLEGRO_DISPLAY* display = al_create_display(RENDER_WIDTH * RENDER_SCALE,
-                                               RENDER_HEIGHT * RENDER_SCALE);
+  al_set_new_display_flags(ALLEGRO_RESIZABLE);
+  int initialScale = options.renderScale > 0 ? options.renderScale
+                                             : RENDER_SCALE;
+  ALLEGRO_DISPLAY* display = al_create_display(RENDER_WIDTH * initialScale,
+                                               RENDER_HEIGHT * initialScale);
 
   al_register_event_source(queue, al_get_keyboard_event_source());
   al_register_event_source(queue, al_get_mouse_event_source());
@@ -42,19 +493,46 @@ int real_main(int argc, char** argv) {
   al_init_ttf_addon();
   al_init_image_addon();
 
-  ALLEGRO_FONT* font =
-      al_load_ttf_font("assets/IBMPlexMono-Medium.ttf", FONT_SIZE, 0);
-  ALLEGRO_FONT* big_font =
-      al_load_ttf_font("assets/IBMPlexMono-Medium.ttf", 30, 0);
+  TextRenderer overlayText("assets/IBMPlexMono-Medium.ttf", FONT_SIZE);
+  TextRenderer menuText("assets/IBMPlexMono-Medium.ttf", MENU_FONT_SIZE);
 
   al_hide_mouse_cursor(display);
 
   // Create the game
 
-  Game game;
-  Renderer renderer(RENDER_WIDTH, RENDER_HEIGHT, RENDER_SCALE);
-  Controller controller;
-  renderer.init();
+  std::random_device seeder;
+  JournalHeader seeds = {.gameSeed = seeder(),
+                         .controllerSeed = seeder(),
+                         .mapConfig = options.mapConfig};
+  std::unique_ptr<JournalWriter> journal;
+  if (!options.recordPath.empty()) {
+    journal = std::make_unique<JournalWriter>(options.recordPath, seeds);
+    if (!journal->good()) {
+      std::cerr << "Failed to open journal [" << options.recordPath << "]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  Game game(seeds.gameSeed, options.mapConfig);
+  Renderer renderer(RENDER_WIDTH, RENDER_HEIGHT);
+  Presenter presenter(RENDER_WIDTH, RENDER_HEIGHT, options.renderScale,
+                      options.presentMode);
+  presenter.resize(al_get_display_width(display),
+                   al_get_display_height(display));
+  Controller controller(seeds.controllerSeed);
+  renderer.init(game.cards());
+  std::unique_ptr<FrameCapture> capture;
+  if (!options.capturePath.empty()) {
+    capture = std::make_unique<FrameCapture>(
+        options.capturePath, options.captureFormat, RENDER_WIDTH,
+        RENDER_HEIGHT);
+    if (!capture->good()) {
+      std::cerr << "Failed to open capture [" << options.capturePath << "]"
+                << std::endl;
+      return 1;
+    }
+  }
   game.debug = false;
   game.state = GameState::MAIN_LOOP;
 
@@ -62,28 +540,67 @@ int real_main(int argc, char** argv) {
 
   ALLEGRO_COLOR text_color = al_map_rgb(0, 255, 0);
   ALLEGRO_EVENT event;
-  ALLEGRO_KEYBOARD_STATE ks;
 
-  char strbuff[200];
   bool redraw = true;
+  bool forceRedraw = true;
+  uint64_t lastSignature = 0;
+  // Frames drawn and presented; loop iterations with nothing to draw (most
+  // input events, unchanged ticks) do not count.
   int frame = 0;
 
   al_start_timer(timer);
 
-  std::unordered_set<std::string> debug_flags;
+  FrameArena arena(FRAME_ARENA_SIZE);
+  AllocationCounters frameAllocations = {0, 0};
+  LatencyHistogram latency;
+  bool lowLatency = options.lowLatency;
+  View view = {.zoomOut = 0,
+               .center = Vec2{.x = RENDER_WIDTH / 2.f,
+                              .y = RENDER_HEIGHT / 2.f} -
+                         GRID_ORIGIN};
+
+  MemoryReport memory;
+  auto collectMemory = [&]() {
+    memory.clear();
+    game.reportMemory(memory);
+    controller.reportMemory(memory, game);
+    arena.reportMemory(memory);
+    renderer.reportMemory(memory);
+    overlayText.reportMemory(memory, "overlay");
+    menuText.reportMemory(memory, "menu");
+    if (capture) {
+      capture->reportMemory(memory);
+    }
+  };
+
+  ALLEGRO_MOUSE_STATE mouseState;
+  al_get_mouse_state(&mouseState);
+  Vec2i mouse = {.x = mouseState.x, .y = mouseState.y};
+
+  // The hint search runs on a copy of the game so the frame loop keeps
+  // going; its result is only shown if the position has not moved on.
+  std::future<SearchResult> hint;
+  uint64_t hintHash = 0;
 
   bool done = false;
-  bool checkmouse = false;
-  while (!done) {
-    al_wait_for_event(queue, &event);
+  bool clicked = false;
+  double inputTime = 0;
+  InputCommand command = InputCommand::NONE;
 
+  auto handleEvent = [&](const ALLEGRO_EVENT& event) {
     if (event.type == ALLEGRO_EVENT_DISPLAY_RESIZE) {
-      int width = al_get_display_width(display);
-      int height = (width * RENDER_HEIGHT) / RENDER_WIDTH;
-      // al_resize_display(display, width, height);
       al_acknowledge_resize(display);
-      renderer.reset(RENDER_WIDTH, RENDER_HEIGHT, RENDER_SCALE);
+      presenter.resize(al_get_display_width(display),
+                       al_get_display_height(display));
+      forceRedraw = true;
+    } else if (event.type == ALLEGRO_EVENT_DISPLAY_EXPOSE) {
+      forceRedraw = true;
     } else if (event.type == ALLEGRO_EVENT_TIMER) {
+      if (redraw && capture) {
+        // The previous tick was never drawn; it is folded into this one,
+        // and the recording shows the last frame for it.
+        capture->repeat();
+      }
       redraw = true;
     } else if (event.type == ALLEGRO_EVENT_DISPLAY_CLOSE) {
       done = true;
@@ -98,66 +615,274 @@ int real_main(int argc, char** argv) {
       }
       if (event.keyboard.keycode == ALLEGRO_KEY_F2) {
       }
+      if (event.keyboard.keycode == ALLEGRO_KEY_MINUS ||
+          event.keyboard.keycode == ALLEGRO_KEY_PAD_MINUS) {
+        view.zoomOut = std::min(view.zoomOut + 1, MAX_ZOOM_OUT);
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_EQUALS ||
+          event.keyboard.keycode == ALLEGRO_KEY_PAD_PLUS) {
+        view.zoomOut = std::max(view.zoomOut - 1, 0);
+      }
+      if (view.zoomOut > 0) {
+        // Pan by a quarter of the frame at the current scale.
+        float step = (RENDER_WIDTH / 4.f) * (1 << view.zoomOut);
+        switch (event.keyboard.keycode) {
+          case ALLEGRO_KEY_LEFT:
+            view.center.x -= step;
+            break;
+          case ALLEGRO_KEY_RIGHT:
+            view.center.x += step;
+            break;
+          case ALLEGRO_KEY_UP:
+            view.center.y -= step;
+            break;
+          case ALLEGRO_KEY_DOWN:
+            view.center.y += step;
+            break;
+        }
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_F5) {
+        collectMemory();
+        memory.write(std::cout);
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_F4) {
+        presenter.setMode(presenter.mode() == PresentMode::GPU
+                              ? PresentMode::CPU
+                              : PresentMode::GPU);
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_F3) {
+        lowLatency = !lowLatency;
+        latency.clear();
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_H && !hint.valid()) {
+        SearchConfig config;
+        config.budget = HINT_BUDGET;
+        config.seed = frame;
+        hintHash = game.hash();
+        hint = std::async(std::launch::async, [position = game, config]() {
+          return search(position, config);
+        });
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_Z) {
+        command = InputCommand::UNDO;
+      }
+      if (event.keyboard.keycode == ALLEGRO_KEY_Y) {
+        command = InputCommand::REDO;
+      }
       if (game.state == GameState::MENU &&
           event.keyboard.keycode == ALLEGRO_KEY_SPACE) {
         game.state = GameState::MAIN_LOOP;
       }
+    } else if (event.type == ALLEGRO_EVENT_MOUSE_AXES) {
+      mouse = {.x = event.mouse.x, .y = event.mouse.y};
     } else if (event.type == ALLEGRO_EVENT_MOUSE_BUTTON_DOWN) {
-      checkmouse = true;
+      mouse = {.x = event.mouse.x, .y = event.mouse.y};
+      if (event.mouse.button == 1) {
+        clicked = true;
+      }
     }
+    bool isInput = event.type == ALLEGRO_EVENT_KEY_DOWN ||
+                   event.type == ALLEGRO_EVENT_MOUSE_AXES ||
+                   event.type == ALLEGRO_EVENT_MOUSE_BUTTON_DOWN;
+    if (isInput && inputTime == 0) {
+      inputTime = event.any.timestamp;
+    }
+  };
 
-    al_get_keyboard_state(&ks);
-
-
-    ALLEGRO_MOUSE_STATE mouse;
-    al_get_mouse_state(&mouse);
-    controller.mousePos = {.x = mouse.x, .y = mouse.y};
-    controller.mousePos /= RENDER_SCALE;
-
-    if (checkmouse) {
-      if (al_mouse_button_down(&mouse, 1)) {
-        controller.mouseButton = 1;
+  while (!done) {
+    al_wait_for_event(queue, &event);
+    AllocationCounters frameStart = thread_allocations();
+    arena.reset();
+    // Input handling (undo snapshots, hints) may allocate; only frames
+    // without input count as steady state.
+    bool steady = event.type == ALLEGRO_EVENT_TIMER;
+
+    handleEvent(event);
+    if (lowLatency) {
+      // Fold every pending event into this tick so the frame drawn below
+      // reflects all input received so far.
+      while (al_get_next_event(queue, &event)) {
+        steady = steady && event.type == ALLEGRO_EVENT_TIMER;
+        handleEvent(event);
       }
-      checkmouse = false;
     }
+
+    InputFrame input = {.dt = 0,
+                        .mousePos = mouse,
+                        .mouseButton = clicked ? 1 : 0,
+                        .command = command,
+                        .timestamp = inputTime};
+    command = InputCommand::NONE;
+    clicked = false;
+    inputTime = 0;
+    input.mousePos = presenter.toFrame(input.mousePos);
+
     uint32_t ticks = al_get_time() * 1000;
     uint32_t dt = ticks - last_ticks;
-    if (!game.gameover) {
-      controller.command(game);
+    input.dt = dt;
+    if (view.zoomOut > 0) {
+      // The overview is view-only and does not animate: no hover, no clicks
+      // and no game time, and the journal records it that way.
+      input.mousePos = OFF_GRID;
+      input.mouseButton = 0;
+      input.dt = 0;
+    }
+    controller.step(game, input);
+    if (hint.valid() && hint.wait_for(std::chrono::seconds(0)) ==
+                            std::future_status::ready) {
+      SearchResult result = hint.get();
+      if (game.hash() == hintHash) {
+        game.highlightedTiles.clear();
+        if (!result.moves.empty()) {
+          game.highlightedTiles.push_back(result.moves.front().move.target);
+        }
+      }
+    }
+    if (options.verifyHash && game.hash() != game.computeHash()) {
+      std::cerr << "Hash mismatch at frame " << frame << std::endl;
+      exit(1);
+    }
+    if (journal) {
+      journal->record(input);
     }
-    game.update(dt);
     last_ticks = ticks;
 
-    if (redraw && al_is_event_queue_empty(queue)) {
+    Vec2i cursor = view.zoomOut > 0 ? presenter.toFrame(mouse)
+                                    : controller.mousePos;
+    if (redraw && lowLatency) {
+      // Late latch: the cursor is drawn where the mouse is now, not where
+      // it was when the tick started.
+      al_get_mouse_state(&mouseState);
+      cursor = presenter.toFrame({.x = mouseState.x, .y = mouseState.y});
+    }
+    uint64_t signature = renderer.signature(game, view, cursor);
+    // Nothing on screen can have changed; keep showing the last frame. The
+    // debug overlay and the menu are not covered by the signature.
+    bool unchanged = !forceRedraw && !game.debug &&
+                     game.state == GameState::MAIN_LOOP &&
+                     signature == lastSignature;
+    if (redraw && unchanged) {
+      controller.takeInputTime();
+      if (capture) {
+        capture->repeat();
+      }
+      redraw = false;
+    }
+
+    if (redraw && (lowLatency || al_is_event_queue_empty(queue))) {
       al_clear_to_color(al_map_rgb(0, 0, 0));
       if (game.state == GameState::MAIN_LOOP) {
-        renderer.draw(game, controller);
+        renderer.draw(game, view, cursor, arena);
+        if (capture) {
+          capture->capture(renderer.frame());
+        }
+        presenter.present(renderer.frame());
       }
+      int displayWidth = al_get_display_width(display);
       if (game.state == GameState::MENU) {
         int line = 0;
-        al_draw_text(big_font, text_color, RENDER_WIDTH * RENDER_SCALE / 2,
-                     150 + ++line * 30, ALLEGRO_ALIGN_CENTRE, "Menu");
+        menuText.draw(text_color, (displayWidth - menuText.width("Menu")) / 2,
+                      150 + ++line * MENU_FONT_SIZE, "Menu");
         ++line;
       }
 
       if (game.debug) {
-        int debugX = RENDER_WIDTH * RENDER_SCALE - 400;
+        if (frame % MEMORY_REFRESH_FRAMES == 0 || memory.entries().empty()) {
+          collectMemory();
+        }
+        int debugX = displayWidth - 400;
         int stri = 0;
-        snprintf(strbuff, sizeof(strbuff), "FPS: %.1f", 1000.f / dt);
-        al_draw_text(font, DEBUG_COLOR, debugX, ++stri * FONT_SIZE, 0, strbuff);
-        snprintf(strbuff, sizeof(strbuff), "Mouse: %d / %d", mouse.x, mouse.y);
-        al_draw_text(font, DEBUG_COLOR, debugX, ++stri * FONT_SIZE, 0, strbuff);
+        TextLine line;
+        overlayText.begin();
+        line << "FPS: ";
+        line.fixed(1000.f / std::max(dt, 1u));
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Mouse: " << mouse.x << " / " << mouse.y;
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Allocs: " << frameAllocations.allocations << " ("
+             << frameAllocations.bytes << " B)";
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Arena: " << arena.used() << " / " << arena.capacity() << " B";
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Latency" << (lowLatency ? " (low)" : "") << ": p50 "
+             << static_cast<int>(latency.percentile(0.5)) << " p99 "
+             << static_cast<int>(latency.percentile(0.99)) << " max "
+             << static_cast<int>(latency.max()) << " ms";
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Zoom: 1/" << (1 << view.zoomOut);
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Present"
+             << (presenter.mode() == PresentMode::CPU ? " (cpu)" : "") << " x"
+             << presenter.factor() << ": ";
+        line.fixed(presenter.lastPresentMs());
+        line << " ms";
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        if (capture) {
+          CaptureStats captured = capture->stats();
+          line << "Capture: " << captured.frames << " drop "
+               << captured.dropped << " ";
+          line.fixed(captured.lastCaptureMs);
+          line << " ms";
+          overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+          line.clear();
+        }
+        MemoryUsage map = memory.total(MemoryCategory::MAP);
+        MemoryUsage history = memory.total(MemoryCategory::HISTORY);
+        MemoryUsage transient = memory.total(MemoryCategory::FRAME);
+        MemoryUsage textures = memory.total(MemoryCategory::TEXTURES);
+        MemoryUsage fonts = memory.total(MemoryCategory::FONTS);
+        line << "Mem KB: map " << map.cpuBytes / 1024 << " hist "
+             << history.cpuBytes / 1024 << " frame "
+             << transient.cpuBytes / 1024;
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        line.clear();
+        line << "Mem KB: tex " << textures.cpuBytes / 1024 << "+"
+             << textures.gpuBytes / 1024 << " fonts "
+             << (fonts.cpuBytes + fonts.gpuBytes) / 1024;
+        overlayText.draw(DEBUG_COLOR, debugX, ++stri * FONT_SIZE, line);
+        overlayText.end();
+        draw_latency_histogram(latency, debugX, (stri + 1) * FONT_SIZE + 4);
       }
 
       al_flip_display();
+      if (auto input = controller.takeInputTime()) {
+        latency.add((al_get_time() - *input) * 1000);
+      }
 
       redraw = false;
+      forceRedraw = false;
+      lastSignature = signature;
+      ++frame;
     }
 
-    ++frame;
+    frameAllocations = thread_allocations() - frameStart;
+    if (options.assertNoAlloc && steady && frame > ALLOCATION_WARMUP_FRAMES &&
+        frameAllocations.allocations > 0) {
+      std::cerr << "Frame " << frame << " allocated "
+                << frameAllocations.allocations << " times ("
+                << frameAllocations.bytes << " bytes)" << std::endl;
+      std::abort();
+    }
+  }
+
+  if (journal) {
+    journal->flush();
+  }
+  if (capture) {
+    CaptureStats captured = capture->stats();
+    // Waits for the encoder to write out the queued frames.
+    capture.reset();
+    std::cout << "Captured " << captured.frames << " frames, "
+              << captured.dropped << " dropped" << std::endl;
   }
 
-  al_destroy_font(font);
   al_destroy_display(display);
   al_destroy_timer(timer);
   al_destroy_event_queue(queue);
@@ -0,0 +1,114 @@
+#include "mapgen.h"
+
+#include <cmath>
+
+#include "parallel.h"
+
+namespace {
+constexpr float SQRT3 = 1.7320508f;
+
+uint32_t hash(int32_t x, int32_t y, uint32_t seed) {
+  uint32_t h = seed ^ (static_cast<uint32_t>(x) * 0x27d4eb2d) ^
+               (static_cast<uint32_t>(y) * 0x165667b1);
+  h ^= h >> 15;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+float lattice(int32_t x, int32_t y, uint32_t seed) {
+  return (hash(x, y, seed) >> 8) * (1.f / (1 << 24));
+}
+
+float smooth(float t) {
+  return t * t * (3 - 2 * t);
+}
+
+float value_noise(float x, float y, uint32_t seed) {
+  float fx = std::floor(x);
+  float fy = std::floor(y);
+  int32_t ix = static_cast<int32_t>(fx);
+  int32_t iy = static_cast<int32_t>(fy);
+  float tx = smooth(x - fx);
+  float ty = smooth(y - fy);
+  float a = lattice(ix, iy, seed);
+  float b = lattice(ix + 1, iy, seed);
+  float c = lattice(ix, iy + 1, seed);
+  float d = lattice(ix + 1, iy + 1, seed);
+  float top = a + (b - a) * tx;
+  float bottom = c + (d - c) * tx;
+  return top + (bottom - top) * ty;
+}
+
+// Three octaves of value noise, normalized to [0, 1).
+float fractal_noise(float x, float y, uint32_t seed) {
+  float sum = value_noise(x, y, seed) * 4;
+  sum += value_noise(x * 2, y * 2, seed + 1) * 2;
+  sum += value_noise(x * 4, y * 4, seed + 2);
+  return sum / 7;
+}
+
+TileType terrain(float x, float y, uint32_t seed) {
+  constexpr float FEATURE_SCALE = 1.f / 6;
+  float elevation = fractal_noise(x * FEATURE_SCALE, y * FEATURE_SCALE, seed);
+  if (elevation > 0.72f) {
+    return TileType::TREE;
+  }
+  if (elevation < 0.25f) {
+    return TileType::SAND;
+  }
+  float moisture =
+      fractal_noise(x * FEATURE_SCALE, y * FEATURE_SCALE, seed ^ 0x9e3779b9);
+  if (moisture > 0.6f) {
+    return TileType::MOSS;
+  }
+  if (moisture > 0.45f) {
+    return TileType::LUSH_GRASS;
+  }
+  return TileType::GRASS;
+}
+
+TileType tile_type(const MapConfig& config, int q, int r, uint32_t seed) {
+  int last = config.size - 1;
+  if (config.shape == MapShape::HEXAGON) {
+    int cutoff = hex_cutoff(config.size);
+    if (q + r < cutoff || q + r > 2 * last - cutoff) {
+      return TileType::NONE;
+    }
+    if (q == 0 || q == last || r == 0 || r == last || q + r == cutoff ||
+        q + r == 2 * last - cutoff) {
+      return TileType::CONTROL;
+    }
+  } else if (q == 0 || q == last || r == 0 || r == last) {
+    return TileType::CONTROL;
+  }
+  // Sample in cartesian space so features are not skewed along the axes.
+  return terrain(1.5f * q, SQRT3 * (r + q * 0.5f), seed);
+}
+}  // namespace
+
+Grid generate_map(const MapConfig& config, uint32_t seed) {
+  Grid map(config.size, config.size);
+  int chunkRows = map.chunkRows();
+  parallel_for(
+      map.chunkCount(),
+      [&map, &config, chunkRows, seed](size_t chunk) {
+        int q0 = static_cast<int>(chunk / chunkRows) * CHUNK_SIZE;
+        int r0 = static_cast<int>(chunk % chunkRows) * CHUNK_SIZE;
+        int q1 = std::min(q0 + CHUNK_SIZE, map.width());
+        int r1 = std::min(r0 + CHUNK_SIZE, map.height());
+        for (int q = q0; q < q1; ++q) {
+          for (int r = r0; r < r1; ++r) {
+            // Chunks are not shared yet, so concurrent edits of distinct
+            // chunks never reallocate.
+            Tile& tile = map.edit(q, r);
+            tile.setType(tile_type(config, q, r, seed));
+            tile.setObj(Object::NONE);
+          }
+        }
+      },
+      config.threads);
+  return map;
+}
@@ -0,0 +1,26 @@
+#ifndef MAPGEN_H
+#define MAPGEN_H
+
+#include <cstdint>
+
+#include "grid.h"
+#include "shape.h"
+
+// Largest map side accepted from the command line, a journal or the
+// network.
+constexpr int MAX_MAP_SIZE = 8192;
+
+struct MapConfig {
+  int size = 11;
+  MapShape shape = MapShape::HEXAGON;
+  // 0 uses every hardware thread.
+  unsigned threads = 0;
+};
+
+// Builds a size x size map ringed by CONTROL tiles. Terrain comes from
+// seeded value noise sampled per tile, so the result depends only on the
+// config and seed, not on the number of threads. Chunks are generated in
+// parallel.
+Grid generate_map(const MapConfig& config, uint32_t seed);
+
+#endif  // MAPGEN_H
@@ -0,0 +1,91 @@
+#include "memory.h"
+
+namespace {
+void write_string(std::ostream& out, std::string_view text) {
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\';
+    }
+    out << c;
+  }
+  out << '"';
+}
+
+void write_usage(std::ostream& out, MemoryUsage usage) {
+  out << "\"cpu\": " << usage.cpuBytes << ", \"gpu\": " << usage.gpuBytes;
+}
+}  // namespace
+
+std::string_view memory_category_name(MemoryCategory category) {
+  switch (category) {
+    case MemoryCategory::MAP:
+      return "map";
+    case MemoryCategory::HISTORY:
+      return "history";
+    case MemoryCategory::FRAME:
+      return "frame";
+    case MemoryCategory::TEXTURES:
+      return "textures";
+    case MemoryCategory::FONTS:
+      return "fonts";
+  }
+  return "unknown";
+}
+
+void MemoryReport::clear() {
+  entries_.clear();
+  totals_ = {};
+}
+
+void MemoryReport::add(MemoryCategory category, std::string_view name,
+                       size_t cpuBytes, size_t gpuBytes) {
+  entries_.push_back({.category = category,
+                      .name = name,
+                      .usage = {.cpuBytes = cpuBytes, .gpuBytes = gpuBytes}});
+  MemoryUsage& total = totals_[static_cast<size_t>(category)];
+  total.cpuBytes += cpuBytes;
+  total.gpuBytes += gpuBytes;
+}
+
+const std::vector<MemoryEntry>& MemoryReport::entries() const {
+  return entries_;
+}
+
+MemoryUsage MemoryReport::total(MemoryCategory category) const {
+  return totals_[static_cast<size_t>(category)];
+}
+
+MemoryUsage MemoryReport::total() const {
+  MemoryUsage sum = {0, 0};
+  for (const MemoryUsage& total : totals_) {
+    sum.cpuBytes += total.cpuBytes;
+    sum.gpuBytes += total.gpuBytes;
+  }
+  return sum;
+}
+
+void MemoryReport::write(std::ostream& out) const {
+  out << "{\"total\": {";
+  write_usage(out, total());
+  out << "},\n \"categories\": {";
+  for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+    out << (i > 0 ? ", " : "");
+    write_string(out, memory_category_name(static_cast<MemoryCategory>(i)));
+    out << ": {";
+    write_usage(out, totals_[i]);
+    out << "}";
+  }
+  out << "},\n \"entries\": [";
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const MemoryEntry& entry = entries_[i];
+    out << (i > 0 ? ",\n  " : "\n  ") << "{\"category\": ";
+    write_string(out, memory_category_name(entry.category));
+    out << ", \"name\": ";
+    write_string(out, entry.name);
+    out << ", ";
+    write_usage(out, entry.usage);
+    out << "}";
+  }
+  out << "]}" << std::endl;
+}
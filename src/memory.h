@@ -0,0 +1,58 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+enum class MemoryCategory {
+  // Tile storage of the live game.
+  MAP,
+  // Snapshots kept for undo/redo beyond what they share with the map.
+  HISTORY,
+  // Per-frame transient containers.
+  FRAME,
+  TEXTURES,
+  FONTS,
+};
+
+constexpr size_t MEMORY_CATEGORY_COUNT = 5;
+
+std::string_view memory_category_name(MemoryCategory category);
+
+struct MemoryUsage {
+  size_t cpuBytes;
+  size_t gpuBytes;
+};
+
+struct MemoryEntry {
+  MemoryCategory category;
+  // Must outlive the report; owners pass static or member strings.
+  std::string_view name;
+  MemoryUsage usage;
+};
+
+// Bytes held per category, filled in by the owners through their
+// reportMemory() methods. clear() keeps the entry storage, so a report that
+// is rebuilt periodically stops allocating once it has reached its size.
+class MemoryReport {
+ public:
+  void clear();
+  void add(MemoryCategory category, std::string_view name, size_t cpuBytes,
+           size_t gpuBytes = 0);
+
+  const std::vector<MemoryEntry>& entries() const;
+  MemoryUsage total(MemoryCategory category) const;
+  MemoryUsage total() const;
+
+  // Machine-readable dump as a single JSON object.
+  void write(std::ostream& out) const;
+
+ private:
+  std::vector<MemoryEntry> entries_;
+  std::array<MemoryUsage, MEMORY_CATEGORY_COUNT> totals_ = {};
+};
+
+#endif  // MEMORY_H
@@ -0,0 +1,294 @@
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+namespace {
+// Largest message accepted; a join snapshot of a very large map is well
+// below this.
+constexpr uint32_t MAX_MESSAGE = 64 * 1024 * 1024;
+constexpr int LISTEN_BACKLOG = 16;
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+struct SocketAddress {
+  sockaddr_storage storage;
+  socklen_t length;
+  int family;
+  std::string unixPath;
+};
+
+bool parse_address(const std::string& address, SocketAddress& out) {
+  std::memset(&out.storage, 0, sizeof(out.storage));
+  if (address.rfind("unix:", 0) == 0) {
+    std::string path = address.substr(5);
+    sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&out.storage);
+    if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+      return false;
+    }
+    un->sun_family = AF_UNIX;
+    std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+    out.length = sizeof(sockaddr_un);
+    out.family = AF_UNIX;
+    out.unixPath = path;
+    return true;
+  }
+  if (address.rfind("tcp:", 0) == 0) {
+    size_t colon = address.rfind(':');
+    if (colon <= 4) {
+      return false;
+    }
+    std::string host = address.substr(4, colon - 4);
+    int port = std::atoi(address.c_str() + colon + 1);
+    sockaddr_in* in = reinterpret_cast<sockaddr_in*>(&out.storage);
+    in->sin_family = AF_INET;
+    in->sin_port = htons(port);
+    if (port <= 0 || port > 65535 ||
+        inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1) {
+      return false;
+    }
+    out.length = sizeof(sockaddr_in);
+    out.family = AF_INET;
+    return true;
+  }
+  return false;
+}
+
+// Lockstep messages are tiny and latency bound; do not let Nagle hold them.
+void set_no_delay(int fd, int family) {
+  if (family == AF_INET) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+}
+
+bool write_all(int fd, const uint8_t* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::send(fd, data, size, SEND_FLAGS);
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+
+// Waits for the socket to become readable; no deadline waits forever.
+bool wait_readable(int fd, const Deadline& deadline) {
+  if (!deadline) {
+    return true;
+  }
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+      *deadline - std::chrono::steady_clock::now());
+  pollfd waiting = {.fd = fd, .events = POLLIN, .revents = 0};
+  return poll(&waiting, 1, std::max<int>(0, left.count())) > 0;
+}
+
+bool read_all(int fd, uint8_t* data, size_t size, const Deadline& deadline) {
+  while (size > 0) {
+    if (!wait_readable(fd, deadline)) {
+      return false;
+    }
+    ssize_t count = ::recv(fd, data, size, 0);
+    if (count <= 0) {
+      return false;
+    }
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+}  // namespace
+
+Connection::Connection(int fd)
+    : fd_(fd)
+    , bytes_sent_(0)
+    , bytes_received_(0) {}
+
+Connection::Connection(Connection&& other)
+    : fd_(std::exchange(other.fd_, -1))
+    , bytes_sent_(other.bytes_sent_)
+    , bytes_received_(other.bytes_received_) {}
+
+Connection& Connection::operator=(Connection&& other) {
+  if (this != &other) {
+    close();
+    fd_ = std::exchange(other.fd_, -1);
+    bytes_sent_ = other.bytes_sent_;
+    bytes_received_ = other.bytes_received_;
+  }
+  return *this;
+}
+
+Connection::~Connection() {
+  close();
+}
+
+Connection Connection::connect(const std::string& address) {
+  SocketAddress target;
+  if (!parse_address(address, target)) {
+    std::cerr << "Bad socket address [" << address << "]" << std::endl;
+    return Connection();
+  }
+  int fd = socket(target.family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return Connection();
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&target.storage),
+                target.length) != 0) {
+    ::close(fd);
+    return Connection();
+  }
+  set_no_delay(fd, target.family);
+  return Connection(fd);
+}
+
+bool Connection::good() const {
+  return fd_ >= 0;
+}
+
+bool Connection::send(const std::vector<uint8_t>& message) {
+  if (fd_ < 0) {
+    return false;
+  }
+  // Prefix and payload go out in one write so a small message is a single
+  // segment.
+  uint32_t size = message.size();
+  uint8_t prefix[4] = {static_cast<uint8_t>(size),
+                       static_cast<uint8_t>(size >> 8),
+                       static_cast<uint8_t>(size >> 16),
+                       static_cast<uint8_t>(size >> 24)};
+  send_buffer_.assign(prefix, prefix + sizeof(prefix));
+  send_buffer_.insert(send_buffer_.end(), message.begin(), message.end());
+  if (!write_all(fd_, send_buffer_.data(), send_buffer_.size())) {
+    close();
+    return false;
+  }
+  bytes_sent_ += send_buffer_.size();
+  return true;
+}
+
+bool Connection::receive(std::vector<uint8_t>& message, int timeoutMs) {
+  Deadline deadline;
+  if (timeoutMs >= 0) {
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::milliseconds(timeoutMs);
+  }
+  uint8_t prefix[4];
+  if (fd_ < 0 || !read_all(fd_, prefix, sizeof(prefix), deadline)) {
+    close();
+    return false;
+  }
+  uint32_t size = prefix[0] | prefix[1] << 8 | prefix[2] << 16 |
+                  static_cast<uint32_t>(prefix[3]) << 24;
+  if (size > MAX_MESSAGE) {
+    close();
+    return false;
+  }
+  message.resize(size);
+  if (!read_all(fd_, message.data(), size, deadline)) {
+    close();
+    return false;
+  }
+  bytes_received_ += sizeof(prefix) + size;
+  return true;
+}
+
+void Connection::close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+size_t Connection::bytesSent() const {
+  return bytes_sent_;
+}
+
+size_t Connection::bytesReceived() const {
+  return bytes_received_;
+}
+
+Listener::Listener(const std::string& address)
+    : fd_(-1) {
+  SocketAddress local;
+  if (!parse_address(address, local)) {
+    std::cerr << "Bad socket address [" << address << "]" << std::endl;
+    return;
+  }
+  int fd = socket(local.family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return;
+  }
+  if (local.family == AF_UNIX) {
+    unlink(local.unixPath.c_str());
+  } else {
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  }
+  sockaddr* bound = reinterpret_cast<sockaddr*>(&local.storage);
+  if (bind(fd, bound, local.length) != 0 ||
+      listen(fd, LISTEN_BACKLOG) != 0) {
+    std::cerr << "Failed to listen on [" << address << "]: "
+              << std::strerror(errno) << std::endl;
+    ::close(fd);
+    return;
+  }
+  fd_ = fd;
+  unix_path_ = local.unixPath;
+}
+
+Listener::~Listener() {
+  close();
+}
+
+bool Listener::good() const {
+  return fd_ >= 0;
+}
+
+Connection Listener::accept(int timeoutMs) {
+  if (fd_ < 0) {
+    return Connection();
+  }
+  pollfd waiting = {.fd = fd_, .events = POLLIN, .revents = 0};
+  if (poll(&waiting, 1, timeoutMs) <= 0) {
+    return Connection();
+  }
+  int fd = ::accept(fd_, nullptr, nullptr);
+  if (fd < 0) {
+    return Connection();
+  }
+  set_no_delay(fd, unix_path_.empty() ? AF_INET : AF_UNIX);
+  return Connection(fd);
+}
+
+void Listener::close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+    if (!unix_path_.empty()) {
+      unlink(unix_path_.c_str());
+    }
+  }
+}
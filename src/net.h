@@ -0,0 +1,63 @@
+#ifndef NET_H
+#define NET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Socket addresses are "unix:<path>" for a Unix domain socket or
+// "tcp:<host>:<port>" (numeric host) for TCP.
+
+// A connected stream socket carrying length-prefixed messages. Calls block
+// unless given a timeout; an invalid connection fails every send and
+// receive.
+class Connection {
+ public:
+  explicit Connection(int fd = -1);
+  Connection(Connection&& other);
+  Connection& operator=(Connection&& other);
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+  ~Connection();
+
+  static Connection connect(const std::string& address);
+
+  bool good() const;
+  bool send(const std::vector<uint8_t>& message);
+  // timeoutMs bounds the wait for the whole message; a negative timeout
+  // waits forever. A message that does not arrive in time closes the
+  // connection, since it is left partway through the stream.
+  bool receive(std::vector<uint8_t>& message, int timeoutMs = -1);
+  void close();
+
+  // Payload and framing bytes, both directions.
+  size_t bytesSent() const;
+  size_t bytesReceived() const;
+
+ private:
+  int fd_;
+  size_t bytes_sent_;
+  size_t bytes_received_;
+  std::vector<uint8_t> send_buffer_;
+};
+
+class Listener {
+ public:
+  explicit Listener(const std::string& address);
+  Listener(const Listener&) = delete;
+  Listener& operator=(const Listener&) = delete;
+  ~Listener();
+
+  bool good() const;
+  // Waits up to timeoutMs for a client; returns an invalid connection if
+  // none arrived.
+  Connection accept(int timeoutMs = 0);
+  void close();
+
+ private:
+  int fd_;
+  std::string unix_path_;
+};
+
+#endif  // NET_H
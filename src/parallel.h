@@ -0,0 +1,45 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline unsigned worker_count(unsigned requested = 0) {
+  if (requested != 0) {
+    return requested;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls f(i) for every i in [0, count) from up to `threads` threads. Work
+// is handed out one index at a time, so indices should be coarse (e.g. one
+// map chunk each).
+template <typename F>
+void parallel_for(size_t count, F f, unsigned threads = 0) {
+  threads = std::min<size_t>(worker_count(threads), count);
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      f(i);
+    }
+    return;
+  }
+  std::atomic<size_t> next = 0;
+  auto work = [&next, &f, count]() {
+    for (size_t i = next++; i < count; i = next++) {
+      f(i);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (unsigned worker = 1; worker < threads; ++worker) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+#endif  // PARALLEL_H
@@ -0,0 +1,118 @@
+#include "png.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+// Largest payload of a stored deflate block.
+constexpr size_t STORED_BLOCK = 65535;
+constexpr uint32_t ADLER_MOD = 65521;
+
+constexpr std::array<uint32_t, 256> make_crc_table() {
+  std::array<uint32_t, 256> table = {};
+  for (uint32_t n = 0; n < 256; ++n) {
+    uint32_t c = n;
+    for (int k = 0; k < 8; ++k) {
+      c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    }
+    table[n] = c;
+  }
+  return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = make_crc_table();
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+  uint32_t c = 0xffffffffu;
+  for (size_t i = 0; i < size; ++i) {
+    c = CRC_TABLE[(c ^ data[i]) & 0xff] ^ (c >> 8);
+  }
+  return c ^ 0xffffffffu;
+}
+
+void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back(value >> 24);
+  out.push_back(value >> 16);
+  out.push_back(value >> 8);
+  out.push_back(value);
+}
+
+// Chunks are written in place: begin_chunk reserves the length and writes
+// the type, finish_chunk fills in the length of everything appended since
+// and adds the CRC.
+size_t begin_chunk(std::vector<uint8_t>& out, const char* type) {
+  put_u32(out, 0);
+  size_t typeStart = out.size();
+  out.insert(out.end(), type, type + 4);
+  return typeStart;
+}
+
+void finish_chunk(std::vector<uint8_t>& out, size_t typeStart) {
+  size_t dataSize = out.size() - typeStart - 4;
+  uint8_t* length = out.data() + typeStart - 4;
+  length[0] = dataSize >> 24;
+  length[1] = dataSize >> 16;
+  length[2] = dataSize >> 8;
+  length[3] = dataSize;
+  put_u32(out, crc32(out.data() + typeStart, dataSize + 4));
+}
+}  // namespace
+
+void encode_png(const uint8_t* rgba, ptrdiff_t stride, int width, int height,
+                std::vector<uint8_t>& out) {
+  out.clear();
+  out.insert(out.end(), SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+
+  size_t header = begin_chunk(out, "IHDR");
+  put_u32(out, width);
+  put_u32(out, height);
+  // 8-bit RGB, deflate, standard filters, no interlace.
+  out.insert(out.end(), {8, 2, 0, 0, 0});
+  finish_chunk(out, header);
+
+  // Every row is a filter byte (0, none) and its RGB bytes; the rows are
+  // cut into stored blocks as they are written.
+  size_t rowBytes = 1 + static_cast<size_t>(width) * 3;
+  size_t total = rowBytes * height;
+  size_t data = begin_chunk(out, "IDAT");
+  out.reserve(out.size() + total + total / STORED_BLOCK * 5 + 64);
+  out.push_back(0x78);
+  out.push_back(0x01);
+  uint32_t a = 1, b = 0;
+  size_t blockLeft = 0;
+  size_t written = 0;
+  auto put = [&](uint8_t byte) {
+    if (blockLeft == 0) {
+      size_t size = std::min(STORED_BLOCK, total - written);
+      out.push_back(written + size == total ? 1 : 0);
+      out.push_back(size);
+      out.push_back(size >> 8);
+      out.push_back(~size);
+      out.push_back(~size >> 8);
+      blockLeft = size;
+    }
+    out.push_back(byte);
+    --blockLeft;
+    ++written;
+    a += byte;
+    b += a;
+    // Folding every byte keeps both sums in range without a counter.
+    a = a >= ADLER_MOD ? a - ADLER_MOD : a;
+    b = b >= ADLER_MOD ? b - ADLER_MOD : b;
+  };
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* row = rgba + y * stride;
+    put(0);
+    for (int x = 0; x < width; ++x) {
+      put(row[x * 4]);
+      put(row[x * 4 + 1]);
+      put(row[x * 4 + 2]);
+    }
+  }
+  put_u32(out, b << 16 | a);
+  finish_chunk(out, data);
+
+  size_t end = begin_chunk(out, "IEND");
+  finish_chunk(out, end);
+}
@@ -0,0 +1,15 @@
+#ifndef PNG_H
+#define PNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encodes 32-bit RGBA pixels (stride in bytes) as an 8-bit RGB PNG; alpha is
+// dropped. The image data uses stored (uncompressed) deflate blocks: files
+// are about the size of the raw pixels, but encoding is a copy plus two
+// checksums and needs no zlib.
+void encode_png(const uint8_t* rgba, ptrdiff_t stride, int width, int height,
+                std::vector<uint8_t>& out);
+
+#endif  // PNG_H
@@ -0,0 +1,86 @@
+#include "present.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "upscale.h"
+#include "util.h"
+
+Presenter::Presenter(int width, int height, int scale, PresentMode mode)
+    : width_(width)
+    , height_(height)
+    , scale_(scale)
+    , mode_(mode)
+    , factor_(std::max(scale, 1))
+    , offset_({0, 0})
+    , last_present_ms_(0) {}
+
+void Presenter::resize(int displayWidth, int displayHeight) {
+  int fit =
+      std::max(1, std::min(displayWidth / width_, displayHeight / height_));
+  factor_ = scale_ > 0 ? std::min(scale_, fit) : fit;
+  offset_ = {(displayWidth - width_ * factor_) / 2,
+             (displayHeight - height_ * factor_) / 2};
+}
+
+void Presenter::present(ALLEGRO_BITMAP* frame) {
+  auto start = std::chrono::steady_clock::now();
+  if (mode_ == PresentMode::CPU) {
+    presentCpu(frame);
+  } else {
+    al_draw_scaled_bitmap(frame, 0, 0, width_, height_, offset_.x, offset_.y,
+                          width_ * factor_, height_ * factor_, 0);
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  last_present_ms_ = elapsed.count();
+}
+
+void Presenter::presentCpu(ALLEGRO_BITMAP* frame) {
+  ALLEGRO_BITMAP* target = al_get_target_bitmap();
+  int x = std::max(offset_.x, 0);
+  int y = std::max(offset_.y, 0);
+  int w = std::min(width_ * factor_, al_get_bitmap_width(target) - x);
+  int h = std::min(height_ * factor_, al_get_bitmap_height(target) - y);
+  if (w < width_ * factor_ || h < height_ * factor_) {
+    // Smaller than one frame; the GPU blit clips for us.
+    al_draw_scaled_bitmap(frame, 0, 0, width_, height_, offset_.x, offset_.y,
+                          width_ * factor_, height_ * factor_, 0);
+    return;
+  }
+  ALLEGRO_LOCKED_REGION* src = al_lock_bitmap(
+      frame, ALLEGRO_PIXEL_FORMAT_ABGR_8888, ALLEGRO_LOCK_READONLY);
+  if (!src) {
+    return;
+  }
+  ALLEGRO_LOCKED_REGION* dst =
+      al_lock_bitmap_region(target, x, y, w, h, ALLEGRO_PIXEL_FORMAT_ABGR_8888,
+                            ALLEGRO_LOCK_WRITEONLY);
+  if (dst) {
+    upscale_nearest(static_cast<const uint8_t*>(src->data), src->pitch,
+                    width_, height_, static_cast<uint8_t*>(dst->data),
+                    dst->pitch, factor_);
+    al_unlock_bitmap(target);
+  }
+  al_unlock_bitmap(frame);
+}
+
+Vec2i Presenter::toFrame(Vec2i displayPos) const {
+  return (displayPos - offset_) / factor_;
+}
+
+int Presenter::factor() const {
+  return factor_;
+}
+
+PresentMode Presenter::mode() const {
+  return mode_;
+}
+
+void Presenter::setMode(PresentMode mode) {
+  mode_ = mode;
+}
+
+double Presenter::lastPresentMs() const {
+  return last_present_ms_;
+}
@@ -0,0 +1,48 @@
+#ifndef PRESENT_H
+#define PRESENT_H
+
+#include <allegro5/allegro5.h>
+
+#include "data.h"
+
+enum class PresentMode {
+  // Scaled blit of the frame bitmap on the GPU.
+  GPU,
+  // Locks both bitmaps and upscales on the CPU, for memory (software or
+  // headless) displays where a scaled blit is a slow per-pixel loop.
+  CPU,
+};
+
+// Copies the low resolution frame to the display at an integer
+// nearest-neighbor scale, centered with black borders when the display
+// aspect does not match.
+class Presenter {
+ public:
+  // A scale of 0 picks the largest factor that fits the display.
+  Presenter(int width, int height, int scale, PresentMode mode);
+
+  void resize(int displayWidth, int displayHeight);
+  void present(ALLEGRO_BITMAP* frame);
+
+  // Maps display coordinates (e.g. the mouse) to frame coordinates.
+  Vec2i toFrame(Vec2i displayPos) const;
+
+  int factor() const;
+  PresentMode mode() const;
+  void setMode(PresentMode mode);
+  double lastPresentMs() const;
+
+ private:
+  void presentCpu(ALLEGRO_BITMAP* frame);
+
+ private:
+  int width_;
+  int height_;
+  int scale_;
+  PresentMode mode_;
+  int factor_;
+  Vec2i offset_;
+  double last_present_ms_;
+};
+
+#endif  // PRESENT_H
@@ -5,10 +5,12 @@
 #include <allegro5/allegro_ttf.h>
 #include <allegro5/bitmap.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <iostream>
 
+#include "bitmap_memory.h"
 #include "util.h"
 
 constexpr int FONT_SIZE = 10;
@@ -20,6 +22,22 @@ constexpr ALLEGRO_COLOR OBSIDIAN = {0, 0, 0, 0.9};
 
 constexpr ALLEGRO_COLOR EARTH7 = {244. / 255, 204. / 255, 161. / 255, 1};
 
+// Overview cells narrower than this merge into the next summary level, which
+// bounds the number of cells drawn by the frame size.
+constexpr float MIN_CELL_PIXELS = 6;
+// Tile and object sprites are drawn this far left of and above the hex
+// center.
+constexpr float SPRITE_LEFT = HEX_SIZE + 2;
+constexpr float SPRITE_TOP = 35;
+constexpr int SPRITE_WIDTH = 36;
+constexpr int SPRITE_HEIGHT = 48;
+// Debug labels per tile: q, r and the draw order.
+constexpr int LABELS_PER_TILE = 3;
+
+constexpr ALLEGRO_COLOR HEAT = {0.9, 0.2, 0.6, 1};
+// Object density at which an overview cell is fully HEAT colored.
+constexpr float HEAT_SATURATION = 0.25;
+
 constexpr std::pair<Texture, const char*> TEXTURE_FILES[] = {
     {Texture::CURSOR, "assets/cursors/cursor.png"},
     {Texture::BACKGROUND, "assets/textures/background.png"},
@@ -36,9 +54,6 @@ constexpr std::pair<Texture, const char*> TEXTURE_FILES[] = {
     {Texture::OBJECT_SPORES_01, "assets/textures/object-spores-01.png"},
     {Texture::OBJECT_SPORES_02, "assets/textures/object-spores-02.png"},
     {Texture::OBJECT_SPORES_03, "assets/textures/object-spores-03.png"},
-    {Texture::CARD_RAIN_M, "assets/textures/card-rain-m.png"},
-    {Texture::CARD_SPORES_M, "assets/textures/card-spores-m.png"},
-    {Texture::CARD_WIND_M, "assets/textures/card-wind-m.png"},
 };
 
 namespace {
@@ -47,20 +62,20 @@ Vec2 flat_hex_corner(Vec2 center, int size, int i) {
   return {center.x + size * cos(angle_rad), center.y + size * sin(angle_rad)};
 }
 
-Texture animation_frame_object(const Tile& tile) {
-  switch (tile.obj) {
+Texture animation_frame_object(const Tile& tile, int frame) {
+  switch (tile.obj()) {
     case Object::SHROOM:
-      if (tile.obj_frame == 0 || tile.obj_frame == 2) {
+      if (frame == 0 || frame == 2) {
         return Texture::OBJECT_SHROOM_01;
-      } else if (tile.obj_frame == 1) {
+      } else if (frame == 1) {
         return Texture::OBJECT_SHROOM_02;
       } else {
         return Texture::OBJECT_SHROOM_03;
       }
     case Object::SPORES:
-      if (tile.obj_frame == 0 || tile.obj_frame == 4) {
+      if (frame == 0 || frame == 4) {
         return Texture::OBJECT_SPORES_01;
-      } else if (tile.obj_frame == 1 || tile.obj_frame == 3) {
+      } else if (frame == 1 || frame == 3) {
         return Texture::OBJECT_SPORES_02;
       } else {
         return Texture::OBJECT_SPORES_03;
@@ -71,17 +86,21 @@ Texture animation_frame_object(const Tile& tile) {
 }
 
 Texture animation_frame_tile(const Tile& tile) {
-  switch (tile.type) {
+  switch (tile.type()) {
     case TileType::GRASS:
       return Texture::TILE_GRASS_01;
     case TileType::LUSH_GRASS:
+    case TileType::MOSS:
+    case TileType::TREE:
       return Texture::TILE_LUSH_GRASS_01;
+    case TileType::SAND:
+      return Texture::TILE_GRASS_01;
     case TileType::CONTROL:
-      if (tile.tile_frame == 0) {
+      if (tile.tileFrame() == 0) {
         return Texture::TILE_CONTROL_01;
-      } else if (tile.tile_frame == 1) {
+      } else if (tile.tileFrame() == 1) {
         return Texture::TILE_CONTROL_02;
-      } else if (tile.tile_frame == 2) {
+      } else if (tile.tileFrame() == 2) {
         return Texture::TILE_CONTROL_03;
       } else {
         return Texture::TILE_CONTROL_04;
@@ -90,58 +109,179 @@ Texture animation_frame_tile(const Tile& tile) {
       return Texture::TILE_OUTLINE;
   }
 }
+struct DebugLabel {
+  float x, y;
+  ALLEGRO_COLOR color;
+  int value;
+};
+
+// Terrain without its own artwork reuses a grass texture with a tint.
+ALLEGRO_COLOR terrain_tint(TileType type) {
+  switch (type) {
+    case TileType::MOSS:
+      return {0.6, 0.85, 0.6, 1};
+    case TileType::SAND:
+      return {1.0, 0.9, 0.55, 1};
+    case TileType::TREE:
+      return {0.35, 0.55, 0.35, 1};
+    default:
+      return {1, 1, 1, 1};
+  }
+}
+
+// Flat terrain colors for the overview, close to the average of the sprites.
+ALLEGRO_COLOR terrain_color(TileType type) {
+  switch (type) {
+    case TileType::CONTROL:
+      return {0.55, 0.5, 0.45, 1};
+    case TileType::GRASS:
+      return {0.49, 0.69, 0.31, 1};
+    case TileType::LUSH_GRASS:
+      return {0.33, 0.58, 0.27, 1};
+    case TileType::MOSS:
+      return {0.24, 0.5, 0.2, 1};
+    case TileType::SAND:
+      return {0.86, 0.78, 0.5, 1};
+    case TileType::TREE:
+      return {0.15, 0.35, 0.15, 1};
+    default:
+      return {0, 0, 0, 0};
+  }
+}
+
+// Loads a bitmap relative to the resources path; a missing asset is fatal.
+ALLEGRO_BITMAP* load_texture(const char* file) {
+  ALLEGRO_PATH* path = al_get_standard_path(ALLEGRO_RESOURCES_PATH);
+  al_join_paths(path, al_create_path(file));
+  std::cout << "Loading [" << al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP)
+            << "] ... ";
+  auto* texture = al_load_bitmap(al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP));
+  if (!texture) {
+    std::cout << "ERROR" << std::endl;
+    std::cerr << "Failed to load ["
+              << al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP) << "] "
+              << al_get_errno() << std::endl;
+    exit(1);
+  }
+  std::cout << " OK" << std::endl;
+  return texture;
+}
+
+ALLEGRO_COLOR lerp_color(ALLEGRO_COLOR a, ALLEGRO_COLOR b, float t) {
+  return {a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t,
+          a.b + (b.b - a.b) * t, a.a + (b.a - a.a) * t};
+}
 }  // namespace
 
-Renderer::Renderer(int width, int height, int scale)
+Renderer::Renderer(int width, int height)
     : width_(width)
     , height_(height)
-    , scale_(scale)
-    , display_(al_get_current_display())
-    , font_(al_load_ttf_font("assets/IBMPlexMono-Medium.ttf", FONT_SIZE, 0),
-            al_destroy_font)
-    , bitmap_(al_create_bitmap(400, 300), al_destroy_bitmap) {
-  dialog_font_line_height = al_get_font_line_height(font_.get());
+    , text_("assets/IBMPlexMono-Medium.ttf", FONT_SIZE)
+    , bitmap_(al_create_bitmap(width, height), al_destroy_bitmap) {
+  dialog_font_line_height = text_.lineHeight();
+}
+
+Renderer::~Renderer() {
+  for (auto [texture, bitmap] : textures_) {
+    al_destroy_bitmap(bitmap);
+  }
+  for (const CardTexture& card : card_textures_) {
+    al_destroy_bitmap(card.bitmap);
+  }
 }
 
-void Renderer::init() {
+void Renderer::init(const CardBook& cards) {
   for (auto [k, v] : TEXTURE_FILES) {
-    ALLEGRO_PATH* path = al_get_standard_path(ALLEGRO_RESOURCES_PATH);
-    al_join_paths(path, al_create_path(v));
-    std::cout << "Loading [" << al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP)
-              << "] ... ";
-    auto* texture = al_load_bitmap(al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP));
-    if (!texture) {
-      std::cout << "ERROR" << std::endl;
-      std::cerr << "Failed to load ["
-                << al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP) << "] "
-                << al_get_errno() << std::endl;
-      exit(1);
-    }
+    auto* texture = load_texture(v);
     textures_[k] = texture;
     texture_dimensions_[k] = {
         static_cast<float>(al_get_bitmap_width(texture)),
         static_cast<float>(al_get_bitmap_height(texture)),
     };
-    std::cout << " OK" << std::endl;
+  }
+  // Card faces come from the card definitions and are indexed by CardId.
+  for (CardId id = 0; id < cards.size(); ++id) {
+    const std::string& file = cards.effect(id).texture;
+    card_textures_.push_back({file, load_texture(file.c_str())});
   }
 }
 
-void Renderer::reset(int width, int height, int scale) {
-  width_ = width;
-  height_ = height;
-  scale_ = scale;
-}
-
-void Renderer::draw(const Game& game, const Controller& controller) const {
+void Renderer::draw(const Game& game, const View& view, Vec2i cursor,
+                    FrameArena& arena) const {
+  ALLEGRO_BITMAP* target = al_get_target_bitmap();
   al_set_target_bitmap(bitmap_.get());
   al_clear_to_color(EARTH7);
   drawBackground();
-  drawGrid(game);
-  drawCards(game);
-  drawCursor(game, controller.mousePos);
-  al_set_target_bitmap(al_get_backbuffer(display_));
-  al_draw_scaled_bitmap(bitmap_.get(), 0, 0, width_, height_, 0, 0,
-                        width_ * scale_, height_ * scale_, 0);
+  if (view.zoomOut > 0) {
+    drawOverview(game, view, arena);
+  } else {
+    drawGrid(game, arena);
+    drawCards(game);
+  }
+  drawCursor(game, cursor);
+  al_set_target_bitmap(target);
+}
+
+ALLEGRO_BITMAP* Renderer::frame() const {
+  return bitmap_.get();
+}
+
+void Renderer::reportMemory(MemoryReport& report) const {
+  for (auto [texture, file] : TEXTURE_FILES) {
+    auto it = textures_.find(texture);
+    if (it != textures_.end()) {
+      MemoryUsage usage = bitmap_memory(it->second);
+      report.add(MemoryCategory::TEXTURES, file, usage.cpuBytes,
+                 usage.gpuBytes);
+    }
+  }
+  for (const CardTexture& card : card_textures_) {
+    MemoryUsage usage = bitmap_memory(card.bitmap);
+    report.add(MemoryCategory::TEXTURES, card.file, usage.cpuBytes,
+               usage.gpuBytes);
+  }
+  MemoryUsage frame = bitmap_memory(bitmap_.get());
+  report.add(MemoryCategory::TEXTURES, "frame", frame.cpuBytes,
+             frame.gpuBytes);
+  text_.reportMemory(report, "debug labels");
+}
+
+uint64_t Renderer::signature(const Game& game, const View& view,
+                             Vec2i cursor) const {
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](int64_t value) {
+    hash = (hash ^ static_cast<uint64_t>(value)) * 1099511628211ull;
+  };
+  auto mixHex = [&mix](const std::optional<Hex3>& hex) {
+    mix(hex ? hex->q : -1);
+    mix(hex ? hex->r : -1);
+  };
+  auto mixIndex = [&mix](const std::optional<size_t>& index) {
+    mix(index ? static_cast<int64_t>(*index) : -1);
+  };
+  mix(game.revision());
+  mix(view.zoomOut);
+  mix(static_cast<int64_t>(view.center.x));
+  mix(static_cast<int64_t>(view.center.y));
+  mix(cursor.x);
+  mix(cursor.y);
+  mix(game.debug);
+  mixHex(game.hoveredTile);
+  mixHex(game.selectedTile);
+  mixIndex(game.hoveredCard);
+  mixIndex(game.selectedCard);
+  for (const Card& card : game.deck) {
+    mix(card.amount);
+    mix(card.selectingOrigin);
+    mix(card.selectingDirection);
+  }
+  for (Hex3 hex : game.affectedTiles) {
+    mixHex(hex);
+  }
+  for (Hex3 hex : game.highlightedTiles) {
+    mixHex(hex);
+  }
+  return hash;
 }
 
 void Renderer::drawBackground() const {
@@ -157,113 +297,215 @@ void Renderer::drawBackground() const {
   }
 }
 
-void Renderer::drawGrid(const Game& game) const {
-  size_t q = 0;
-  size_t r = 0;
-  size_t qbeg = 0;
-  size_t rbeg = 0;
-  int order = 0;
-  while (true) {
-    if (q < game.map.size() && r < game.map.size()) {
-      const Tile& tile = game.map[q][r];
-      Vec2 c = hex2point(tile.coords, HEX_SIZE);
+void Renderer::drawGrid(const Game& game, FrameArena& arena) const {
+  // Sorted tile indices of the tinted tiles, so each tile is a binary search
+  // instead of a scan of the whole list.
+  FrameVector<int> affected{ArenaAllocator<int>(arena)};
+  FrameVector<int> highlighted{ArenaAllocator<int>(arena)};
+  auto index = [&game](Hex3 hex) { return hex.q * game.map.height() + hex.r; };
+  affected.reserve(game.affectedTiles.size());
+  for (Hex3 hex : game.affectedTiles) {
+    affected.push_back(index(hex));
+  }
+  highlighted.reserve(game.highlightedTiles.size());
+  for (Hex3 hex : game.highlightedTiles) {
+    highlighted.push_back(index(hex));
+  }
+  std::sort(affected.begin(), affected.end());
+  std::sort(highlighted.begin(), highlighted.end());
+
+  // Only the window of columns and screen rows (see for_each_draw_order)
+  // whose sprites can touch the frame is walked, so the cost and the labels
+  // follow the frame size and not the map size. A column is 1.5 hex sizes
+  // wide, a screen row half a hex tall.
+  float qStep = 1.5f * HEX_SIZE;
+  float rowStep = sqrtf(3.f) / 2 * HEX_SIZE;
+  DrawWindow window = {
+      .qBegin = static_cast<int>(std::floor(
+          (SPRITE_LEFT - SPRITE_WIDTH - GRID_ORIGIN.x) / qStep)),
+      .qEnd = static_cast<int>(std::ceil(
+                  (width_ + SPRITE_LEFT - GRID_ORIGIN.x) / qStep)) +
+              1,
+      .rowBegin = static_cast<int>(std::floor(
+          (SPRITE_TOP - SPRITE_HEIGHT - GRID_ORIGIN.y) / rowStep)),
+      .rowEnd = static_cast<int>(std::ceil(
+                    (height_ + SPRITE_TOP - GRID_ORIGIN.y) / rowStep)) +
+                1,
+  };
+  FrameVector<DebugLabel> labels{ArenaAllocator<DebugLabel>(arena)};
+  if (game.debug) {
+    // Every row holds at most every other column of the window.
+    size_t visibleTiles =
+        static_cast<size_t>(window.rowEnd - window.rowBegin) *
+        ((window.qEnd - window.qBegin + 1) / 2);
+    labels.reserve(visibleTiles * LABELS_PER_TILE);
+  }
+
+  game.withShape([&](auto shape) {
+    shape.forEachDrawn(window, [&](int q, int r, int order) {
+      Hex3 coords = {q, r, -q - r};
+      Vec2 c = hex2point(coords, HEX_SIZE);
       Vec2 cr = c + GRID_ORIGIN;
+      const Tile& tile = game.map.at(q, r);
 
-      bool windControl =
-          tile.type == TileType::CONTROL &&
-          (game.selectedCard && game.peekActiveCard().type == CardType::WIND_M);
+      bool windControl = tile.type() == TileType::CONTROL &&
+                         game.selectedCard &&
+                         game.effectOf(*game.selectedCard).directional;
 
-      if (tile.type != TileType::NONE &&
-          (tile.type != TileType::CONTROL || windControl)) {
+      if (tile.type() != TileType::NONE &&
+          (tile.type() != TileType::CONTROL || windControl)) {
         Texture texture = animation_frame_tile(tile);
         bool shouldDraw = false;
         if (windControl) {
           if (game.peekActiveCard().selectingOrigin) {
             shouldDraw = true;
-          } else if (game.selectedTile == tile.coords) {
+          } else if (game.selectedTile == coords) {
             shouldDraw = true;
           }
         } else {
           shouldDraw = true;
         }
         if (shouldDraw) {
-          al_draw_bitmap(textures_.at(texture), cr.x - HEX_SIZE - 2, cr.y - 35,
-                         0);
+          al_draw_tinted_bitmap(textures_.at(texture),
+                                terrain_tint(tile.type()), cr.x - SPRITE_LEFT,
+                                cr.y - SPRITE_TOP, 0);
         }
         if (game.selectedCard) {
-          if (game.isAffected(tile.coords)) {
+          if (std::binary_search(affected.begin(), affected.end(),
+                                 index(coords))) {
             al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE);
-            ALLEGRO_COLOR tint = al_map_rgba_f(0.5, 0.5, 0.5, 1);
-            if (game.deck[*game.selectedCard].type == CardType::SPORES_M) {
-              tint = al_map_rgba_f(0.5, 0.0, 0.5, 1);
-            } else if (game.deck[*game.selectedCard].type == CardType::RAIN_M) {
-              tint = al_map_rgba_f(0.0, 0.3, 0.5, 1);
-            }
+            const auto& rgb = game.effectOf(*game.selectedCard).tint;
+            ALLEGRO_COLOR tint = al_map_rgba_f(rgb[0], rgb[1], rgb[2], 1);
             al_draw_tinted_bitmap(textures_.at(texture), tint,
-                                  cr.x - HEX_SIZE - 2, cr.y - 35, 0);
+                                  cr.x - SPRITE_LEFT, cr.y - SPRITE_TOP, 0);
             al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
           }
         }
+        if (std::binary_search(highlighted.begin(), highlighted.end(),
+                               index(coords))) {
+          al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE);
+          al_draw_tinted_bitmap(textures_.at(texture),
+                                al_map_rgba_f(0.4, 0.4, 0.0, 1),
+                                cr.x - SPRITE_LEFT, cr.y - SPRITE_TOP, 0);
+          al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
+        }
 
-        if (tile.obj != Object::NONE) {
-          Texture obj_texture = animation_frame_object(tile);
+        if (tile.obj() != Object::NONE) {
+          Texture obj_texture =
+              animation_frame_object(tile, game.objectFrame(tile));
 
-          al_draw_bitmap(textures_.at(obj_texture), cr.x - HEX_SIZE - 2,
-                         cr.y - 35, 0);
+          al_draw_bitmap(textures_.at(obj_texture), cr.x - SPRITE_LEFT,
+                         cr.y - SPRITE_TOP, 0);
         }
         if (game.debug) {
-          al_draw_textf(font_.get(), CYAN, cr.x, cr.y - 15, 0, "%d",
-                        tile.coords.q);
-          al_draw_textf(font_.get(), MAGENTA, cr.x + 5, cr.y - 5, 0, "%d",
-                        tile.coords.r);
+          labels.push_back({cr.x, cr.y - 15, CYAN, coords.q});
+          labels.push_back({cr.x + 5, cr.y - 5, MAGENTA, coords.r});
         }
       }
       if (game.debug) {
-        al_draw_textf(font_.get(), BLACK, cr.x - 5, cr.y - 5, 0, "%d", order);
+        labels.push_back({cr.x - 5, cr.y - 5, BLACK, order});
       }
-    }
-    if (q == game.map.size() - 1 && r == game.map.size() - 1) {
-      break;
-    }
-    order += 1;
-    if (q + 2 >= game.map.size() || r == 0) {
-      qbeg += 1;
-      if (qbeg == 2) {
-        qbeg = 0;
-        rbeg += 1;
+    });
+  });
+
+  // Labels are drawn after all tiles so that they go out as one batch
+  // instead of breaking the sprite batch once per tile.
+  text_.begin();
+  for (const DebugLabel& label : labels) {
+    text_.draw(label.color, label.x, label.y, label.value);
+  }
+  text_.end();
+}
+
+void Renderer::drawOverview(const Game& game, const View& view,
+                            FrameArena& arena) const {
+  const MapSummary& summary = game.summary();
+  if (summary.levels() == 0) {
+    return;
+  }
+  float scale = 1.f / (1 << view.zoomOut);
+  // A step in q moves 1.5 hex sizes right; see hex2point.
+  float qStep = 1.5f * HEX_SIZE;
+  float rStep = sqrtf(3.f) * HEX_SIZE;
+  size_t level = 0;
+  while (level + 1 < summary.levels() &&
+         summary.cellTiles(level) * qStep * scale < MIN_CELL_PIXELS) {
+    ++level;
+  }
+  int cell = summary.cellTiles(level);
+
+  // Only the cells overlapping the frame are visited, so the cost depends
+  // on the frame size and not on the map size.
+  float halfWidth = width_ / 2.f / scale;
+  float halfHeight = height_ / 2.f / scale;
+  float qMin = (view.center.x - halfWidth) / qStep;
+  float qMax = (view.center.x + halfWidth) / qStep;
+  float rMin = (view.center.y - halfHeight) / rStep - qMax / 2;
+  float rMax = (view.center.y + halfHeight) / rStep - qMin / 2;
+  auto cellRange = [cell](float lo, float hi, int count) {
+    int first = std::clamp(static_cast<int>(std::floor(lo / cell)) - 1, 0,
+                           count);
+    int last = std::clamp(static_cast<int>(std::floor(hi / cell)) + 2, 0,
+                          count);
+    return std::pair(first, last);
+  };
+  auto [columnBegin, columnEnd] =
+      cellRange(qMin, qMax, summary.columns(level));
+  auto [rowBegin, rowEnd] = cellRange(rMin, rMax, summary.rows(level));
+
+  auto toFrame = [&](float q, float r) {
+    float x = qStep * q;
+    float y = rStep * (q / 2 + r);
+    return Vec2{(x - view.center.x) * scale + width_ / 2.f,
+                (y - view.center.y) * scale + height_ / 2.f};
+  };
+  FrameVector<ALLEGRO_VERTEX> vertices{ArenaAllocator<ALLEGRO_VERTEX>(arena)};
+  vertices.reserve((columnEnd - columnBegin) * (rowEnd - rowBegin) * 6);
+  for (int column = columnBegin; column < columnEnd; ++column) {
+    for (int row = rowBegin; row < rowEnd; ++row) {
+      const TileSummary& tiles = summary.at(level, column, row);
+      uint32_t count = tiles.tiles();
+      if (count == 0) {
+        continue;
+      }
+      float density = static_cast<float>(tiles.objects()) / count;
+      ALLEGRO_COLOR color =
+          lerp_color(terrain_color(tiles.dominant()), HEAT,
+                     std::min(1.f, density / HEAT_SATURATION));
+      // Tile centers sit on integer coordinates, so a cell's edges are half
+      // a tile outside its first and last tiles.
+      float q0 = column * cell - .5f;
+      float r0 = row * cell - .5f;
+      float q1 = std::min(column * cell + cell, game.map.width()) - .5f;
+      float r1 = std::min(row * cell + cell, game.map.height()) - .5f;
+      Vec2 corners[] = {toFrame(q0, r0), toFrame(q1, r0), toFrame(q1, r1),
+                        toFrame(q0, r1)};
+      for (int corner : {0, 1, 2, 0, 2, 3}) {
+        vertices.push_back({.x = corners[corner].x,
+                            .y = corners[corner].y,
+                            .z = 0,
+                            .u = 0,
+                            .v = 0,
+                            .color = color});
       }
-      q = qbeg;
-      r = rbeg;
-    } else {
-      q += 2;
-      r -= 1;
     }
   }
+  if (!vertices.empty()) {
+    al_draw_prim(vertices.data(), nullptr, nullptr, 0, vertices.size(),
+                 ALLEGRO_PRIM_TRIANGLE_LIST);
+  }
 }
 
 void Renderer::drawCards(const Game& game) const {
   int cardTypeIndex = 0;
   for (const Card& card : game.deck) {
-    Texture texture;
-    switch (card.type) {
-      case CardType::RAIN_M:
-        texture = Texture::CARD_RAIN_M;
-        break;
-      case CardType::SPORES_M:
-        texture = Texture::CARD_SPORES_M;
-        break;
-      case CardType::WIND_M:
-        texture = Texture::CARD_WIND_M;
-        break;
-      default:
-        continue;
-    }
+    ALLEGRO_BITMAP* texture = card_textures_[card.id].bitmap;
 
     int cardX = DECK_ORIGIN.x;
     int cardY = DECK_ORIGIN.y + cardTypeIndex * 72;
 
     for (int j = 0; j < card.amount; ++j) {
-      al_draw_bitmap(textures_.at(texture), cardX + j * 12, cardY + j * 8, 0);
+      al_draw_bitmap(texture, cardX + j * 12, cardY + j * 8, 0);
     }
     Vec2 lastCardOffset;
     lastCardOffset.x = (card.amount - 1) * 12;
@@ -275,9 +517,8 @@ void Renderer::drawCards(const Game& game) const {
     } else if (cardTypeIndex == game.hoveredCard) {
       al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE);
       ALLEGRO_COLOR tint = al_map_rgba_f(0.2, 0.2, 0.2, 1);
-      al_draw_tinted_bitmap(textures_.at(texture), tint,
-                            cardX + lastCardOffset.x, cardY + lastCardOffset.y,
-                            0);
+      al_draw_tinted_bitmap(texture, tint, cardX + lastCardOffset.x,
+                            cardY + lastCardOffset.y, 0);
       al_set_blender(ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_INVERSE_ALPHA);
     }
     ++cardTypeIndex;
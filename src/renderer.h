@@ -8,40 +8,73 @@
 #include <cstdint>
 #include <map>
 #include <random>
+#include <string>
+#include <vector>
 
-#include "controller.h"
+#include "arena.h"
 #include "game.h"
+#include "text.h"
 
 struct Pixel {
   int16_t x, y;
 };
 
+// Which part of the map the frame shows. zoomOut 0 is the normal tile view;
+// every further step halves the scale and is drawn from the map summary
+// instead of per-tile sprites, centered on `center` (grid space, see
+// hex2point).
+struct View {
+  int zoomOut;
+  Vec2 center;
+};
+
+constexpr int MAX_ZOOM_OUT = 12;
+
 class Renderer {
  public:
-  Renderer(int width, int height, int scale);
-  void init();
-  void reset(int width, int height, int scale);
+  Renderer(int width, int height);
+  ~Renderer();
+  // Loads the fixed textures and the card faces named by `cards`.
+  void init(const CardBook& cards);
 
-  void draw(const Game& game, const Controller& controller) const;
+  // Renders into the low resolution frame bitmap; see Presenter for getting
+  // it onto the display.
+  void draw(const Game& game, const View& view, Vec2i cursor,
+            FrameArena& arena) const;
+  ALLEGRO_BITMAP* frame() const;
+  // Changes whenever something that draw() depends on changes, so an
+  // unchanged frame does not need to be drawn or presented again.
+  uint64_t signature(const Game& game, const View& view,
+                     Vec2i cursor) const;
+
+  void reportMemory(MemoryReport& report) const;
 
  private:
   void drawBackground() const;
-  void drawGrid(const Game& game) const;
+  void drawGrid(const Game& game, FrameArena& arena) const;
+  void drawOverview(const Game& game, const View& view,
+                    FrameArena& arena) const;
   void drawCards(const Game& game) const;
   void drawCursor(const Game& game, const Vec2i mousePos) const;
 
+ private:
+  struct CardTexture {
+    std::string file;
+    ALLEGRO_BITMAP* bitmap;
+  };
+
  private:
   int width_;
   int height_;
-  int scale_;
-  ALLEGRO_DISPLAY* display_;
 
   Vec2i grid_origin;
 
   mutable std::default_random_engine random_generator_;
   std::map<Texture, ALLEGRO_BITMAP*> textures_;
   std::map<Texture, Vec2> texture_dimensions_;
-  std::unique_ptr<ALLEGRO_FONT, void (*)(ALLEGRO_FONT*)> font_;
+  // Indexed by CardId.
+  std::vector<CardTexture> card_textures_;
+  TextRenderer text_;
   std::unique_ptr<ALLEGRO_BITMAP, void (*)(ALLEGRO_BITMAP*)> bitmap_;
   int dialog_font_line_height;
 };
@@ -0,0 +1,66 @@
+#include "replay.h"
+
+#include <algorithm>
+
+Replay::Replay(const Journal& journal, size_t keyframeInterval)
+    : journal_(journal)
+    , keyframe_interval_(std::max<size_t>(keyframeInterval, 1))
+    , tick_(0)
+    , game_(journal.header().gameSeed, journal.header().mapConfig)
+    , controller_(journal.header().controllerSeed) {
+  game_.state = GameState::MAIN_LOOP;
+  keyframes_.push_back({game_, controller_});
+}
+
+size_t Replay::tick() const {
+  return tick_;
+}
+
+bool Replay::done() const {
+  return tick_ >= journal_.size();
+}
+
+void Replay::step() {
+  if (done()) {
+    return;
+  }
+  controller_.step(game_, journal_.at(tick_));
+  ++tick_;
+  if (tick_ % keyframe_interval_ == 0 &&
+      tick_ / keyframe_interval_ == keyframes_.size()) {
+    keyframes_.push_back({game_, controller_});
+  }
+}
+
+void Replay::runToEnd() {
+  while (!done()) {
+    step();
+  }
+}
+
+void Replay::seek(size_t tick) {
+  tick = std::min(tick, journal_.size());
+  size_t keyframe =
+      std::min(tick / keyframe_interval_, keyframes_.size() - 1);
+  size_t keyframeTick = keyframe * keyframe_interval_;
+  if (tick < tick_ || keyframeTick > tick_) {
+    restore(keyframe);
+  }
+  while (tick_ < tick) {
+    step();
+  }
+}
+
+const Game& Replay::game() const {
+  return game_;
+}
+
+const Controller& Replay::controller() const {
+  return controller_;
+}
+
+void Replay::restore(size_t keyframe) {
+  game_ = keyframes_[keyframe].game;
+  controller_ = keyframes_[keyframe].controller;
+  tick_ = keyframe * keyframe_interval_;
+}
@@ -0,0 +1,52 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <vector>
+
+#include "controller.h"
+#include "game.h"
+#include "journal.h"
+
+constexpr size_t REPLAY_KEYFRAME_INTERVAL = 600;
+
+// Re-runs a recorded journal without any rendering. Every forward step that
+// reaches a multiple of REPLAY_KEYFRAME_INTERVAL for the first time keeps a
+// copy of the full state (cheap, the grids share chunks), so a plain run
+// simulates each tick once. A seek restores the nearest keyframe at or
+// before its target and steps from there: into already visited ticks that
+// is fewer than REPLAY_KEYFRAME_INTERVAL ticks, past them it runs forward
+// and leaves keyframes behind for later seeks.
+class Replay {
+ public:
+  explicit Replay(const Journal& journal,
+                  size_t keyframeInterval = REPLAY_KEYFRAME_INTERVAL);
+
+  size_t tick() const;
+  bool done() const;
+
+  void step();
+  void runToEnd();
+  void seek(size_t tick);
+
+  const Game& game() const;
+  const Controller& controller() const;
+
+ private:
+  struct Keyframe {
+    Game game;
+    Controller controller;
+  };
+
+  void restore(size_t keyframe);
+
+ private:
+  const Journal& journal_;
+  size_t keyframe_interval_;
+  size_t tick_;
+  Game game_;
+  Controller controller_;
+  // keyframes_[i] holds the state right before tick i * keyframe_interval_.
+  std::vector<Keyframe> keyframes_;
+};
+
+#endif  // REPLAY_H
@@ -0,0 +1,101 @@
+#include "search.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace {
+struct MoveStats {
+  double scoreSum = 0;
+  uint64_t rollouts = 0;
+};
+
+void run_worker(const Game& root, const std::vector<Move>& rootMoves,
+                const SearchConfig& config, unsigned worker,
+                std::chrono::steady_clock::time_point deadline,
+                std::vector<MoveStats>& stats) {
+  std::default_random_engine generator(config.seed * 7919 + worker);
+  Snapshot start = root.snapshot();
+  Game sim = root;
+  std::vector<Move> moves;
+  // Workers start at different root moves so that a short budget still
+  // spreads rollouts over all of them.
+  size_t next = worker % rootMoves.size();
+  while (std::chrono::steady_clock::now() < deadline) {
+    sim.restore(start);
+    sim.play(rootMoves[next], generator);
+    for (int depth = 0; depth < config.rolloutDepth; ++depth) {
+      sim.legalMoves(moves);
+      if (moves.empty()) {
+        break;
+      }
+      std::uniform_int_distribution<size_t> pick(0, moves.size() - 1);
+      sim.play(moves[pick(generator)], generator);
+    }
+    stats[next].scoreSum += evaluate(sim);
+    stats[next].rollouts += 1;
+    next = (next + 1) % rootMoves.size();
+  }
+}
+}  // namespace
+
+int evaluate(const Game& game) {
+  const MapSummary& summary = game.summary();
+  if (summary.levels() == 0) {
+    return 0;
+  }
+  const TileSummary& total = summary.at(summary.levels() - 1, 0, 0);
+  return 2 * total.object[static_cast<size_t>(Object::SHROOM)] +
+         total.object[static_cast<size_t>(Object::SPORES)];
+}
+
+SearchResult search(const Game& game, const SearchConfig& config) {
+  auto start = std::chrono::steady_clock::now();
+  SearchResult result = {.moves = {}, .rollouts = 0, .seconds = 0};
+
+  std::vector<Move> rootMoves;
+  game.legalMoves(rootMoves);
+  if (rootMoves.empty()) {
+    return result;
+  }
+
+  unsigned threads = config.threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Each worker owns its statistics; they are only merged after joining.
+  std::vector<std::vector<MoveStats>> stats(
+      threads, std::vector<MoveStats>(rootMoves.size()));
+  std::vector<std::thread> workers;
+  auto deadline = start + config.budget;
+  for (unsigned worker = 0; worker < threads; ++worker) {
+    workers.emplace_back(run_worker, std::cref(game), std::cref(rootMoves),
+                         std::cref(config), worker, deadline,
+                         std::ref(stats[worker]));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  for (size_t i = 0; i < rootMoves.size(); ++i) {
+    MoveStats total;
+    for (const auto& workerStats : stats) {
+      total.scoreSum += workerStats[i].scoreSum;
+      total.rollouts += workerStats[i].rollouts;
+    }
+    result.rollouts += total.rollouts;
+    if (total.rollouts > 0) {
+      result.moves.push_back({rootMoves[i], total.scoreSum / total.rollouts,
+                              total.rollouts});
+    }
+  }
+  std::sort(result.moves.begin(), result.moves.end(),
+            [](const RankedMove& a, const RankedMove& b) {
+              return a.meanScore > b.meanScore;
+            });
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  result.seconds = elapsed.count();
+  return result;
+}
@@ -0,0 +1,40 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+struct SearchConfig {
+  std::chrono::milliseconds budget{100};
+  int rolloutDepth = 8;
+  // 0 uses every hardware thread.
+  unsigned threads = 0;
+  uint32_t seed = 0;
+};
+
+struct RankedMove {
+  Move move;
+  double meanScore;
+  uint64_t rollouts;
+};
+
+struct SearchResult {
+  // Sorted best first.
+  std::vector<RankedMove> moves;
+  uint64_t rollouts;
+  double seconds;
+};
+
+// Heuristic value of a position: grown shrooms count double, spores single.
+// Read off the top of the map summary, so it costs the same on any map.
+int evaluate(const Game& game);
+
+// Flat Monte Carlo search: every legal play from the current position is
+// followed by random playouts of rolloutDepth moves on private copies of the
+// game, spread over all threads until the time budget runs out.
+SearchResult search(const Game& game, const SearchConfig& config);
+
+#endif  // SEARCH_H
@@ -0,0 +1,545 @@
+#include "session.h"
+
+#include <sstream>
+#include <utility>
+
+namespace {
+// How long a new connection gets to introduce itself before it is dropped,
+// so a silent client cannot stall the host's tick loop.
+constexpr int HELLO_TIMEOUT_MS = 1000;
+
+enum MessageType : uint8_t {
+  HELLO = 1,
+  WELCOME = 2,
+  COMMAND = 3,
+  TICK = 4,
+};
+
+// Little-endian base-128 varints; signed values are zigzag encoded so small
+// negative coordinates stay one byte.
+class ByteWriter {
+ public:
+  explicit ByteWriter(std::vector<uint8_t>& out)
+      : out_(out) {
+    out_.clear();
+  }
+
+  void u8(uint8_t value) {
+    out_.push_back(value);
+  }
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      out_.push_back(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    out_.push_back(static_cast<uint8_t>(value));
+  }
+  void svarint(int64_t value) {
+    varint((static_cast<uint64_t>(value) << 1) ^ (value >> 63));
+  }
+  void u64(uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      out_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+  void string(const std::string& value) {
+    varint(value.size());
+    out_.insert(out_.end(), value.begin(), value.end());
+  }
+
+ private:
+  std::vector<uint8_t>& out_;
+};
+
+// Reads past the end return zeros and set failed().
+class ByteReader {
+ public:
+  explicit ByteReader(const std::vector<uint8_t>& in)
+      : in_(in)
+      , pos_(0)
+      , failed_(false) {}
+
+  bool failed() const {
+    return failed_;
+  }
+
+  uint8_t u8() {
+    if (pos_ >= in_.size()) {
+      failed_ = true;
+      return 0;
+    }
+    return in_[pos_++];
+  }
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = u8();
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    failed_ = true;
+    return 0;
+  }
+  int64_t svarint() {
+    uint64_t value = varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+  uint64_t u64() {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= static_cast<uint64_t>(u8()) << (i * 8);
+    }
+    return value;
+  }
+  std::string string() {
+    uint64_t size = varint();
+    if (size > in_.size() - pos_) {
+      failed_ = true;
+      return {};
+    }
+    std::string value(in_.begin() + pos_, in_.begin() + pos_ + size);
+    pos_ += size;
+    return value;
+  }
+
+ private:
+  const std::vector<uint8_t>& in_;
+  size_t pos_;
+  bool failed_;
+};
+
+// Hexes travel as q and r; s is implied.
+void write_hex(ByteWriter& writer, Hex3 hex) {
+  writer.svarint(hex.q);
+  writer.svarint(hex.r);
+}
+
+Hex3 read_hex(ByteReader& reader) {
+  int q = reader.svarint();
+  int r = reader.svarint();
+  return {q, r, -q - r};
+}
+
+void write_move(ByteWriter& writer, const Move& move) {
+  writer.varint(move.card);
+  write_hex(writer, move.target);
+  write_hex(writer, move.direction);
+}
+
+Move read_move(ByteReader& reader) {
+  Move move;
+  move.card = reader.varint();
+  move.target = read_hex(reader);
+  move.direction = read_hex(reader);
+  return move;
+}
+
+// Tiles in the same two bytes as in memory.
+void write_tile(ByteWriter& writer, const Tile& tile) {
+  writer.u8(static_cast<uint8_t>(tile.type()) |
+            static_cast<uint8_t>(tile.obj()) << 4);
+  writer.u8(tile.tileFrame() | tile.objPhase() << 4);
+}
+
+// Leaves the tile alone and fails on a tile type or object this build does
+// not know; both index per-type tables such as the map summary's.
+bool read_tile(ByteReader& reader, Tile& tile) {
+  uint8_t kind = reader.u8();
+  uint8_t frames = reader.u8();
+  if ((kind & 0x0f) >= TILE_TYPE_COUNT || (kind >> 4) >= OBJECT_COUNT) {
+    return false;
+  }
+  tile.setType(static_cast<TileType>(kind & 0x0f));
+  tile.setObj(static_cast<Object>(kind >> 4));
+  tile.setTileFrame(frames & 0x0f);
+  tile.setObjPhase(frames >> 4);
+  return true;
+}
+
+// The tiles of map that differ from base: the number of differing chunks,
+// then per chunk its index, the number of differing tiles and each tile as
+// its offset in the chunk followed by its bytes.
+class MapDiff {
+ public:
+  MapDiff(const Grid& map, const Grid& base)
+      : map_(map)
+      , base_(base) {}
+
+  void write(ByteWriter& writer) {
+    // Chunks still shared with the base are skipped unread. Edited chunks
+    // can end up equal to the base again (a shroom placed and removed);
+    // those are dropped as well.
+    changed_.clear();
+    for (size_t i = 0; i < map_.chunkCount(); ++i) {
+      if (!map_.sharesChunk(base_, i)) {
+        size_t count = 0;
+        forEachChanged(i, [&count](int, int, int) { ++count; });
+        if (count > 0) {
+          changed_.push_back({i, count});
+        }
+      }
+    }
+    writer.varint(changed_.size());
+    for (auto [chunk, count] : changed_) {
+      writer.varint(chunk);
+      writer.varint(count);
+      forEachChanged(chunk, [&](int offset, int q, int r) {
+        writer.u8(offset);
+        write_tile(writer, map_.at(q, r));
+      });
+    }
+  }
+
+ private:
+  template <typename F>
+  void forEachChanged(size_t chunk, F f) const {
+    int column = chunk / map_.chunkRows();
+    int row = chunk % map_.chunkRows();
+    for (int dq = 0; dq < CHUNK_SIZE; ++dq) {
+      for (int dr = 0; dr < CHUNK_SIZE; ++dr) {
+        int q = column * CHUNK_SIZE + dq;
+        int r = row * CHUNK_SIZE + dr;
+        if (map_.contains(q, r) && !(map_.at(q, r) == base_.at(q, r))) {
+          f(dq * CHUNK_SIZE + dr, q, r);
+        }
+      }
+    }
+  }
+
+ private:
+  const Grid& map_;
+  const Grid& base_;
+  std::vector<std::pair<size_t, size_t>> changed_;
+};
+
+bool read_map_diff(ByteReader& reader, Grid& map) {
+  uint64_t changed = reader.varint();
+  for (uint64_t i = 0; i < changed && !reader.failed(); ++i) {
+    uint64_t chunk = reader.varint();
+    uint64_t count = reader.varint();
+    if (chunk >= map.chunkCount()) {
+      return false;
+    }
+    int column = chunk / map.chunkRows();
+    int row = chunk % map.chunkRows();
+    for (uint64_t k = 0; k < count && !reader.failed(); ++k) {
+      uint8_t offset = reader.u8();
+      int q = column * CHUNK_SIZE + offset / CHUNK_SIZE;
+      int r = row * CHUNK_SIZE + offset % CHUNK_SIZE;
+      if (!map.contains(q, r)) {
+        return false;
+      }
+      if (!read_tile(reader, map.edit(q, r))) {
+        return false;
+      }
+    }
+  }
+  return !reader.failed();
+}
+
+// The one rule both ends share: moves in player order, illegal ones
+// ignored, then a fixed step of time.
+void apply_tick(Game& game, std::default_random_engine& generator,
+                const std::vector<Move>& moves) {
+  for (const Move& move : moves) {
+    if (game.legal(move)) {
+      game.play(move, generator);
+    }
+  }
+  game.update(SESSION_TICK_MS);
+}
+
+void add_stats(SessionStats& stats, const Connection& connection) {
+  stats.bytesSent += connection.bytesSent();
+  stats.bytesReceived += connection.bytesReceived();
+}
+}  // namespace
+
+SessionHost::SessionHost(const SessionConfig& config,
+                         const std::string& address)
+    : config_(config)
+    , listener_(address)
+    , game_(config.seed, config.mapConfig)
+    , base_(game_.map)
+    , generator_(config.seed)
+    , tick_(0)
+    , closed_({0, 0, 0}) {
+  game_.state = GameState::MAIN_LOOP;
+}
+
+bool SessionHost::good() const {
+  return listener_.good();
+}
+
+bool SessionHost::admit(int timeoutMs) {
+  Connection connection = listener_.accept(timeoutMs);
+  if (!connection.good()) {
+    return false;
+  }
+  if (!connection.receive(in_, HELLO_TIMEOUT_MS)) {
+    return true;
+  }
+  ByteReader reader(in_);
+  if (reader.u8() != HELLO) {
+    return true;
+  }
+  bool spectator = reader.u8() != 0;
+  int player = -1;
+  if (!spectator && playerCount() < config_.players) {
+    player = playerCount();
+  }
+  encodeWelcome(player, out_);
+  if (!connection.send(out_)) {
+    return true;
+  }
+  if (player >= 0) {
+    players_.push_back(std::move(connection));
+  } else {
+    spectators_.push_back(std::move(connection));
+  }
+  return true;
+}
+
+void SessionHost::encodeWelcome(int player,
+                                std::vector<uint8_t>& message) const {
+  ByteWriter writer(message);
+  writer.u8(WELCOME);
+  writer.svarint(player);
+  writer.varint(config_.seed);
+  writer.varint(config_.mapConfig.size);
+  writer.u8(static_cast<uint8_t>(config_.mapConfig.shape));
+  writer.varint(tick_);
+  std::ostringstream generator;
+  generator << generator_;
+  writer.string(generator.str());
+  writer.varint(game_.deck.size());
+  for (const Card& card : game_.deck) {
+    writer.varint(card.amount);
+  }
+  MapDiff(game_.map, base_).write(writer);
+  writer.u64(game_.hash());
+}
+
+bool SessionHost::step() {
+  while (admit(0)) {
+  }
+  if (playerCount() < config_.players) {
+    return false;
+  }
+
+  moves_.clear();
+  for (Connection& player : players_) {
+    if (!player.receive(in_)) {
+      return false;
+    }
+    ByteReader reader(in_);
+    if (reader.u8() != COMMAND || reader.varint() != tick_) {
+      return false;
+    }
+    if (reader.u8() != 0) {
+      Move move = read_move(reader);
+      if (!reader.failed()) {
+        moves_.push_back(move);
+      }
+    }
+  }
+  apply_tick(game_, generator_, moves_);
+  ++tick_;
+
+  ByteWriter writer(out_);
+  writer.u8(TICK);
+  writer.varint(tick_ - 1);
+  writer.varint(moves_.size());
+  for (const Move& move : moves_) {
+    write_move(writer, move);
+  }
+  bool hashed = tick_ % SESSION_HASH_INTERVAL == 0;
+  writer.u8(hashed);
+  if (hashed) {
+    writer.u64(game_.hash());
+  }
+
+  bool playersGood = true;
+  for (Connection& player : players_) {
+    playersGood = player.send(out_) && playersGood;
+  }
+  for (size_t i = 0; i < spectators_.size();) {
+    if (spectators_[i].send(out_)) {
+      ++i;
+    } else {
+      add_stats(closed_, spectators_[i]);
+      spectators_.erase(spectators_.begin() + i);
+    }
+  }
+  return playersGood;
+}
+
+void SessionHost::close() {
+  listener_.close();
+  for (Connection& player : players_) {
+    player.close();
+  }
+  for (Connection& spectator : spectators_) {
+    spectator.close();
+  }
+}
+
+const Game& SessionHost::game() const {
+  return game_;
+}
+
+uint64_t SessionHost::tick() const {
+  return tick_;
+}
+
+int SessionHost::playerCount() const {
+  return players_.size();
+}
+
+SessionStats SessionHost::stats() const {
+  SessionStats stats = closed_;
+  stats.ticks = tick_;
+  for (const Connection& player : players_) {
+    add_stats(stats, player);
+  }
+  for (const Connection& spectator : spectators_) {
+    add_stats(stats, spectator);
+  }
+  return stats;
+}
+
+SessionClient::SessionClient(const std::string& address, bool spectator)
+    : connection_(Connection::connect(address))
+    , player_(-1)
+    , tick_(0)
+    , desynced_(false)
+    , welcome_bytes_(0) {
+  if (!join(spectator)) {
+    connection_.close();
+  }
+}
+
+bool SessionClient::join(bool spectator) {
+  ByteWriter writer(out_);
+  writer.u8(HELLO);
+  writer.u8(spectator);
+  if (!connection_.send(out_) || !connection_.receive(in_)) {
+    return false;
+  }
+  welcome_bytes_ = connection_.bytesReceived();
+
+  ByteReader reader(in_);
+  if (reader.u8() != WELCOME) {
+    return false;
+  }
+  player_ = reader.svarint();
+  uint32_t seed = reader.varint();
+  MapConfig mapConfig;
+  mapConfig.size = reader.varint();
+  mapConfig.shape = static_cast<MapShape>(reader.u8());
+  tick_ = reader.varint();
+  std::istringstream generator(reader.string());
+  generator >> generator_;
+  // The size comes off the wire; a bogus one must not turn into a huge
+  // map allocation.
+  if (reader.failed() || mapConfig.size < 3 ||
+      mapConfig.size > MAX_MAP_SIZE ||
+      mapConfig.shape > MapShape::PARALLELOGRAM) {
+    return false;
+  }
+
+  game_.emplace(seed, mapConfig);
+  game_->state = GameState::MAIN_LOOP;
+  if (reader.varint() != game_->deck.size()) {
+    return false;
+  }
+  for (Card& card : game_->deck) {
+    card.amount = reader.varint();
+  }
+  Grid map = game_->map;
+  if (!read_map_diff(reader, map)) {
+    return false;
+  }
+  game_->replaceMap(map);
+  // Every tick advances the clock by the same step; catch up with the host.
+  game_->update(tick_ * SESSION_TICK_MS);
+  desynced_ = reader.u64() != game_->hash();
+  return !reader.failed();
+}
+
+bool SessionClient::good() const {
+  return connection_.good();
+}
+
+int SessionClient::player() const {
+  return player_;
+}
+
+bool SessionClient::step(const std::optional<Move>& move) {
+  if (player_ >= 0) {
+    ByteWriter writer(out_);
+    writer.u8(COMMAND);
+    writer.varint(tick_);
+    writer.u8(move.has_value());
+    if (move) {
+      write_move(writer, *move);
+    }
+    if (!connection_.send(out_)) {
+      return false;
+    }
+  }
+  if (!connection_.receive(in_)) {
+    return false;
+  }
+  ByteReader reader(in_);
+  if (reader.u8() != TICK || reader.varint() != tick_) {
+    connection_.close();
+    return false;
+  }
+  // Every move takes several bytes; a larger count is corrupt.
+  uint64_t count = reader.varint();
+  if (count > in_.size()) {
+    connection_.close();
+    return false;
+  }
+  moves_.resize(count);
+  for (Move& tickMove : moves_) {
+    tickMove = read_move(reader);
+  }
+  bool hashed = reader.u8() != 0;
+  uint64_t hash = hashed ? reader.u64() : 0;
+  if (reader.failed()) {
+    connection_.close();
+    return false;
+  }
+  apply_tick(*game_, generator_, moves_);
+  ++tick_;
+  if (hashed && hash != game_->hash()) {
+    desynced_ = true;
+  }
+  return true;
+}
+
+const Game& SessionClient::game() const {
+  return *game_;
+}
+
+uint64_t SessionClient::tick() const {
+  return tick_;
+}
+
+bool SessionClient::desynced() const {
+  return desynced_;
+}
+
+size_t SessionClient::welcomeBytes() const {
+  return welcome_bytes_;
+}
+
+SessionStats SessionClient::stats() const {
+  return {.ticks = tick_,
+          .bytesSent = connection_.bytesSent(),
+          .bytesReceived = connection_.bytesReceived()};
+}
@@ -0,0 +1,118 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "net.h"
+
+// Every peer advances the game by this much per tick, so animation stays
+// in step without exchanging clocks.
+constexpr uint32_t SESSION_TICK_MS = 16;
+// Ticks between state hashes sent for desync detection.
+constexpr uint64_t SESSION_HASH_INTERVAL = 30;
+
+struct SessionConfig {
+  uint32_t seed;
+  MapConfig mapConfig;
+  int players;
+};
+
+struct SessionStats {
+  size_t ticks;
+  size_t bytesSent;
+  size_t bytesReceived;
+};
+
+// Lockstep: every peer runs the same Game. Each tick the host gathers one
+// command (a move, or a pass) from every player, applies them in player
+// order and broadcasts them; the peers apply the same commands with the same
+// generator. Only commands cross the wire, so a tick costs a few bytes per
+// player whatever the map size.
+//
+// Whoever connects after all player slots are taken spectates. A joiner
+// regenerates the map from the seed and is sent only the tiles that differ
+// from it: chunks the live map still shares with the generated one are
+// skipped without looking at their tiles.
+class SessionHost {
+ public:
+  SessionHost(const SessionConfig& config, const std::string& address);
+
+  bool good() const;
+  // Admits at most one waiting connection, waiting up to timeoutMs for it.
+  bool admit(int timeoutMs);
+  // Admits waiting spectators, then resolves one tick. False once a player
+  // has disconnected; the session cannot advance without them.
+  bool step();
+  // Stops listening and disconnects everyone.
+  void close();
+
+  const Game& game() const;
+  uint64_t tick() const;
+  int playerCount() const;
+  SessionStats stats() const;
+
+ private:
+  void encodeWelcome(int player, std::vector<uint8_t>& message) const;
+
+ private:
+  SessionConfig config_;
+  Listener listener_;
+  Game game_;
+  // The map as generated; joiners are sent the difference to it.
+  Grid base_;
+  std::default_random_engine generator_;
+  uint64_t tick_;
+
+  std::vector<Connection> players_;
+  std::vector<Connection> spectators_;
+  // Bytes of connections that have since closed.
+  SessionStats closed_;
+
+  std::vector<Move> moves_;
+  std::vector<uint8_t> in_;
+  std::vector<uint8_t> out_;
+};
+
+class SessionClient {
+ public:
+  SessionClient(const std::string& address, bool spectator);
+
+  bool good() const;
+  // Player index, or -1 when spectating.
+  int player() const;
+  // Players send move for the next tick (nullopt passes); spectators ignore
+  // it. Returns once the tick has been resolved and applied, false if the
+  // host has gone.
+  bool step(const std::optional<Move>& move);
+
+  const Game& game() const;
+  uint64_t tick() const;
+  // Set once a host hash disagrees with the local game.
+  bool desynced() const;
+  // Bytes received on joining, including the map diff.
+  size_t welcomeBytes() const;
+  SessionStats stats() const;
+
+ private:
+  bool join(bool spectator);
+
+ private:
+  Connection connection_;
+  int player_;
+  std::optional<Game> game_;
+  std::default_random_engine generator_;
+  uint64_t tick_;
+  bool desynced_;
+  size_t welcome_bytes_;
+
+  std::vector<Move> moves_;
+  std::vector<uint8_t> in_;
+  std::vector<uint8_t> out_;
+};
+
+#endif  // SESSION_H
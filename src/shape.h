@@ -0,0 +1,167 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum class MapShape {
+  HEXAGON,
+  PARALLELOGRAM,
+};
+
+// A hexagonal map of side `size` keeps the tiles with
+// hex_cutoff(size) <= q + r <= 2 * (size - 1) - hex_cutoff(size).
+constexpr int hex_cutoff(int size) {
+  return (size - 1) / 2;
+}
+
+constexpr bool shape_contains(int size, MapShape shape, int q, int r) {
+  if (static_cast<unsigned>(q) >= static_cast<unsigned>(size) ||
+      static_cast<unsigned>(r) >= static_cast<unsigned>(size)) {
+    return false;
+  }
+  if (shape == MapShape::PARALLELOGRAM) {
+    return true;
+  }
+  int cutoff = hex_cutoff(size);
+  return q + r >= cutoff && q + r <= 2 * (size - 1) - cutoff;
+}
+
+// Hexes sit on screen rows half a hex apart, row = 2 * r + q. A window is
+// the half-open ranges of columns and screen rows a frame can show.
+struct DrawWindow {
+  int qBegin, qEnd;
+  int rowBegin, rowEnd;
+};
+
+// The renderer's back-to-front order over the positions of the size x size
+// square inside window: rows top to bottom, each left to right in steps of
+// two columns, so that overlapping sprites stack correctly. Positions
+// outside the window are never visited, so the cost follows the window and
+// not the map. Calls f(q, r, order), where order counts the positions
+// visited so far.
+template <typename F>
+constexpr void for_each_draw_order(int size, const DrawWindow& window, F f) {
+  int last = size - 1;
+  int order = 0;
+  int rowEnd = std::min(window.rowEnd, 3 * last + 1);
+  for (int row = std::max(window.rowBegin, 0); row < rowEnd; ++row) {
+    // 0 <= r <= last bounds q to [row - 2 * last, row].
+    int q = std::max({window.qBegin, row - 2 * last, 0});
+    // q and row share parity, so r is whole.
+    q += (q ^ row) & 1;
+    for (; q < std::min({window.qEnd, row + 1, size}); q += 2) {
+      f(q, (row - q) / 2, order++);
+    }
+  }
+}
+
+// Bounds and tile list of a map shape fixed at compile time.
+// Every check folds to constants, the tile traversal walks a constexpr
+// table and the draw walk has constant bounds, so the boards that
+// matches are played on do not pay for runtime sizes. RuntimeShape has
+// the same interface for any other map.
+template <int Size, MapShape Shape>
+class FixedShape {
+ public:
+  static constexpr int size() {
+    return Size;
+  }
+  static constexpr bool contains(int q, int r) {
+    return shape_contains(Size, Shape, q, r);
+  }
+  // Calls f(q, r) for every tile inside the shape.
+  template <typename F>
+  static void forEachTile(F f) {
+    for (const Position& tile : TILES) {
+      f(tile.q, tile.r);
+    }
+  }
+  // Calls f(q, r, order) for the window in for_each_draw_order order.
+  template <typename F>
+  static void forEachDrawn(const DrawWindow& window, F f) {
+    for_each_draw_order(Size, window, f);
+  }
+
+ private:
+  struct Position {
+    int16_t q, r;
+  };
+
+  static constexpr size_t tileCount() {
+    size_t count = 0;
+    for (int q = 0; q < Size; ++q) {
+      for (int r = 0; r < Size; ++r) {
+        count += contains(q, r);
+      }
+    }
+    return count;
+  }
+
+  static constexpr std::array<Position, tileCount()> TILES = [] {
+    std::array<Position, tileCount()> tiles = {};
+    size_t i = 0;
+    for (int q = 0; q < Size; ++q) {
+      for (int r = 0; r < Size; ++r) {
+        if (contains(q, r)) {
+          tiles[i++] = {static_cast<int16_t>(q), static_cast<int16_t>(r)};
+        }
+      }
+    }
+    return tiles;
+  }();
+};
+
+class RuntimeShape {
+ public:
+  RuntimeShape(int size, MapShape shape)
+      : size_(size)
+      , shape_(shape) {}
+
+  int size() const {
+    return size_;
+  }
+  bool contains(int q, int r) const {
+    return shape_contains(size_, shape_, q, r);
+  }
+  template <typename F>
+  void forEachTile(F f) const {
+    int cutoff = shape_ == MapShape::HEXAGON ? hex_cutoff(size_) : 0;
+    int last = size_ - 1;
+    for (int q = 0; q < size_; ++q) {
+      // The hexagon cutoff leaves one contiguous run of r per column.
+      int rBegin = shape_ == MapShape::HEXAGON ? std::max(0, cutoff - q) : 0;
+      int rEnd = shape_ == MapShape::HEXAGON
+                     ? std::min(size_, 2 * last - cutoff - q + 1)
+                     : size_;
+      for (int r = rBegin; r < rEnd; ++r) {
+        f(q, r);
+      }
+    }
+  }
+  template <typename F>
+  void forEachDrawn(const DrawWindow& window, F f) const {
+    for_each_draw_order(size_, window, f);
+  }
+
+ private:
+  int size_;
+  MapShape shape_;
+};
+
+using StandardShape = FixedShape<11, MapShape::HEXAGON>;
+
+// Calls f(shape) with StandardShape when size and shape match it and with
+// a RuntimeShape otherwise; f is generic and instantiated for both.
+template <typename F>
+void with_shape(int size, MapShape shape, F f) {
+  if (size == StandardShape::size() && shape == MapShape::HEXAGON) {
+    f(StandardShape());
+  } else {
+    f(RuntimeShape(size, shape));
+  }
+}
+
+#endif  // SHAPE_H
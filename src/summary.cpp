@@ -0,0 +1,161 @@
+#include "summary.h"
+
+#include <algorithm>
+
+TileType TileSummary::dominant() const {
+  size_t best = 0;
+  uint32_t bestCount = 0;
+  for (size_t type = 1; type < TILE_TYPE_COUNT; ++type) {
+    if (terrain[type] > bestCount) {
+      best = type;
+      bestCount = terrain[type];
+    }
+  }
+  return static_cast<TileType>(best);
+}
+
+uint32_t TileSummary::tiles() const {
+  uint32_t count = 0;
+  for (size_t type = 1; type < TILE_TYPE_COUNT; ++type) {
+    count += terrain[type];
+  }
+  return count;
+}
+
+uint32_t TileSummary::objects() const {
+  uint32_t count = 0;
+  for (size_t obj = 1; obj < OBJECT_COUNT; ++obj) {
+    count += object[obj];
+  }
+  return count;
+}
+
+TileSummary& TileSummary::operator+=(const TileSummary& other) {
+  for (size_t type = 0; type < TILE_TYPE_COUNT; ++type) {
+    terrain[type] += other.terrain[type];
+  }
+  for (size_t obj = 0; obj < OBJECT_COUNT; ++obj) {
+    object[obj] += other.object[obj];
+  }
+  return *this;
+}
+
+void MapSummary::build(const Grid& map) {
+  levels_.clear();
+  int columns = map.chunkColumns();
+  int rows = map.chunkRows();
+  while (true) {
+    levels_.push_back({.columns = columns,
+                       .rows = rows,
+                       .cells = std::vector<TileSummary>(columns * rows)});
+    if (columns <= 1 && rows <= 1) {
+      break;
+    }
+    columns = (columns + 1) / 2;
+    rows = (rows + 1) / 2;
+  }
+  for (int column = 0; column < levels_[0].columns; ++column) {
+    for (int row = 0; row < levels_[0].rows; ++row) {
+      scanChunk(map, column, row);
+    }
+  }
+  for (size_t level = 1; level < levels_.size(); ++level) {
+    Level& below = levels_[level - 1];
+    Level& above = levels_[level];
+    for (int column = 0; column < below.columns; ++column) {
+      for (int row = 0; row < below.rows; ++row) {
+        above.cells[(column / 2) * above.rows + row / 2] +=
+            below.cells[column * below.rows + row];
+      }
+    }
+  }
+}
+
+void MapSummary::objectChanged(Hex3 hex, Object before, Object after) {
+  if (before == after || levels_.empty()) {
+    return;
+  }
+  int column = hex.q / CHUNK_SIZE;
+  int row = hex.r / CHUNK_SIZE;
+  for (Level& level : levels_) {
+    TileSummary& cell = level.cells[column * level.rows + row];
+    --cell.object[static_cast<size_t>(before)];
+    ++cell.object[static_cast<size_t>(after)];
+    column /= 2;
+    row /= 2;
+  }
+}
+
+void MapSummary::sync(const Grid& map, const Grid& previous) {
+  if (levels_.empty() || map.chunkColumns() != levels_[0].columns ||
+      map.chunkRows() != levels_[0].rows) {
+    build(map);
+    return;
+  }
+  for (int column = 0; column < levels_[0].columns; ++column) {
+    for (int row = 0; row < levels_[0].rows; ++row) {
+      if (!map.sharesChunk(previous, column * levels_[0].rows + row)) {
+        scanChunk(map, column, row);
+        rebuildAbove(column, row);
+      }
+    }
+  }
+}
+
+size_t MapSummary::levels() const {
+  return levels_.size();
+}
+
+int MapSummary::columns(size_t level) const {
+  return levels_[level].columns;
+}
+
+int MapSummary::rows(size_t level) const {
+  return levels_[level].rows;
+}
+
+int MapSummary::cellTiles(size_t level) const {
+  return CHUNK_SIZE << level;
+}
+
+const TileSummary& MapSummary::at(size_t level, int column, int row) const {
+  return levels_[level].cells[column * levels_[level].rows + row];
+}
+
+size_t MapSummary::memoryBytes() const {
+  size_t bytes = levels_.capacity() * sizeof(Level);
+  for (const Level& level : levels_) {
+    bytes += level.cells.capacity() * sizeof(TileSummary);
+  }
+  return bytes;
+}
+
+void MapSummary::scanChunk(const Grid& map, int column, int row) {
+  TileSummary summary = {};
+  int qEnd = std::min(map.width(), (column + 1) * CHUNK_SIZE);
+  int rEnd = std::min(map.height(), (row + 1) * CHUNK_SIZE);
+  for (int q = column * CHUNK_SIZE; q < qEnd; ++q) {
+    for (int r = row * CHUNK_SIZE; r < rEnd; ++r) {
+      const Tile& tile = map.at(q, r);
+      ++summary.terrain[static_cast<size_t>(tile.type())];
+      ++summary.object[static_cast<size_t>(tile.obj())];
+    }
+  }
+  levels_[0].cells[column * levels_[0].rows + row] = summary;
+}
+
+void MapSummary::rebuildAbove(int column, int row) {
+  for (size_t level = 1; level < levels_.size(); ++level) {
+    column /= 2;
+    row /= 2;
+    const Level& below = levels_[level - 1];
+    TileSummary summary = {};
+    for (int c = column * 2; c < std::min(column * 2 + 2, below.columns);
+         ++c) {
+      for (int r = row * 2; r < std::min(row * 2 + 2, below.rows); ++r) {
+        summary += below.cells[c * below.rows + r];
+      }
+    }
+    levels_[level].cells[column * levels_[level].rows + row] = summary;
+  }
+}
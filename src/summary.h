@@ -0,0 +1,60 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+
+// Aggregate of a square block of tiles.
+struct TileSummary {
+  std::array<uint32_t, TILE_TYPE_COUNT> terrain;
+  std::array<uint32_t, OBJECT_COUNT> object;
+
+  // Most common terrain other than NONE, or NONE for an empty block.
+  TileType dominant() const;
+  uint32_t tiles() const;
+  // Tiles holding any object.
+  uint32_t objects() const;
+
+  TileSummary& operator+=(const TileSummary& other);
+};
+
+// A mipmap-like pyramid of tile summaries: level 0 has one cell per grid
+// chunk and every level above it merges 2x2 cells of the one below, up to a
+// single cell for the whole map. Object changes are applied as deltas along
+// one column of the pyramid, so keeping it current costs O(levels) per
+// change, and a view can draw whichever level matches its scale.
+class MapSummary {
+ public:
+  void build(const Grid& map);
+  void objectChanged(Hex3 hex, Object before, Object after);
+  // The map was replaced by `map`; `previous` is what the summary was built
+  // for. Only chunks the two grids do not share are rescanned.
+  void sync(const Grid& map, const Grid& previous);
+
+  size_t levels() const;
+  int columns(size_t level) const;
+  int rows(size_t level) const;
+  // Side of a level's cells in tiles.
+  int cellTiles(size_t level) const;
+  const TileSummary& at(size_t level, int column, int row) const;
+
+  size_t memoryBytes() const;
+
+ private:
+  struct Level {
+    int columns;
+    int rows;
+    std::vector<TileSummary> cells;
+  };
+
+  void scanChunk(const Grid& map, int column, int row);
+  void rebuildAbove(int column, int row);
+
+ private:
+  std::vector<Level> levels_;
+};
+
+#endif  // SUMMARY_H
@@ -0,0 +1,147 @@
+#include "text.h"
+
+#include <allegro5/allegro_ttf.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "bitmap_memory.h"
+
+namespace {
+constexpr int ATLAS_WIDTH = 256;
+constexpr int GLYPH_PADDING = 1;
+}  // namespace
+
+TextLine::TextLine()
+    : length_(0) {}
+
+TextLine& TextLine::operator<<(std::string_view text) {
+  size_t count = std::min(text.size(), buffer_.size() - length_);
+  std::copy_n(text.data(), count, buffer_.data() + length_);
+  length_ += count;
+  return *this;
+}
+
+TextLine& TextLine::fixed(double value) {
+  long long tenths =
+      static_cast<long long>(value * 10 + (value < 0 ? -.5 : .5));
+  if (tenths < 0) {
+    *this << "-";
+    tenths = -tenths;
+  }
+  *this << tenths / 10 << ".";
+  return *this << static_cast<int>(tenths % 10);
+}
+
+std::string_view TextLine::view() const {
+  return {buffer_.data(), length_};
+}
+
+void TextLine::clear() {
+  length_ = 0;
+}
+
+TextRenderer::TextRenderer(const char* path, int size)
+    : atlas_(nullptr, al_destroy_bitmap)
+    , glyphs_()
+    , line_height_(size) {
+  ALLEGRO_FONT* font = al_load_ttf_font(path, size, 0);
+  if (!font) {
+    std::cerr << "Failed to load font [" << path << "]" << std::endl;
+    exit(1);
+  }
+  line_height_ = al_get_font_line_height(font);
+
+  // Shelf packing: glyphs left to right, a new row when the width runs out.
+  int penX = 0;
+  int penY = 0;
+  int rowHeight = 0;
+  for (int c = FIRST_GLYPH; c <= LAST_GLYPH; ++c) {
+    Glyph& glyph = glyphs_[c - FIRST_GLYPH];
+    int bbx = 0, bby = 0, bbw = 0, bbh = 0;
+    al_get_glyph_dimensions(font, c, &bbx, &bby, &bbw, &bbh);
+    if (penX + bbw + GLYPH_PADDING > ATLAS_WIDTH) {
+      penX = 0;
+      penY += rowHeight + GLYPH_PADDING;
+      rowHeight = 0;
+    }
+    glyph = {.x = penX,
+             .y = penY,
+             .w = bbw,
+             .h = bbh,
+             .offsetX = bbx,
+             .offsetY = bby,
+             .advance = al_get_glyph_advance(font, c, ALLEGRO_NO_KERNING)};
+    penX += bbw + GLYPH_PADDING;
+    rowHeight = std::max(rowHeight, bbh);
+  }
+
+  atlas_.reset(al_create_bitmap(ATLAS_WIDTH, penY + rowHeight));
+  ALLEGRO_BITMAP* target = al_get_target_bitmap();
+  al_set_target_bitmap(atlas_.get());
+  al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+  for (int c = FIRST_GLYPH; c <= LAST_GLYPH; ++c) {
+    const Glyph& glyph = glyphs_[c - FIRST_GLYPH];
+    al_draw_glyph(font, al_map_rgb(255, 255, 255), glyph.x - glyph.offsetX,
+                  glyph.y - glyph.offsetY, c);
+  }
+  al_set_target_bitmap(target);
+  al_destroy_font(font);
+}
+
+int TextRenderer::lineHeight() const {
+  return line_height_;
+}
+
+int TextRenderer::width(std::string_view text) const {
+  int width = 0;
+  for (char c : text) {
+    if (c >= FIRST_GLYPH && c <= LAST_GLYPH) {
+      width += glyphs_[c - FIRST_GLYPH].advance;
+    }
+  }
+  return width;
+}
+
+void TextRenderer::begin() const {
+  al_hold_bitmap_drawing(true);
+}
+
+void TextRenderer::end() const {
+  al_hold_bitmap_drawing(false);
+}
+
+void TextRenderer::draw(ALLEGRO_COLOR color, float x, float y,
+                        std::string_view text) const {
+  for (char c : text) {
+    if (c < FIRST_GLYPH || c > LAST_GLYPH) {
+      continue;
+    }
+    const Glyph& glyph = glyphs_[c - FIRST_GLYPH];
+    if (glyph.w > 0) {
+      al_draw_tinted_bitmap_region(atlas_.get(), color, glyph.x, glyph.y,
+                                   glyph.w, glyph.h, x + glyph.offsetX,
+                                   y + glyph.offsetY, 0);
+    }
+    x += glyph.advance;
+  }
+}
+
+void TextRenderer::draw(ALLEGRO_COLOR color, float x, float y,
+                        int value) const {
+  char buffer[12];
+  auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  draw(color, x, y, std::string_view(buffer, end - buffer));
+}
+
+void TextRenderer::draw(ALLEGRO_COLOR color, float x, float y,
+                        const TextLine& line) const {
+  draw(color, x, y, line.view());
+}
+
+void TextRenderer::reportMemory(MemoryReport& report,
+                                std::string_view name) const {
+  MemoryUsage atlas = bitmap_memory(atlas_.get());
+  report.add(MemoryCategory::FONTS, name, atlas.cpuBytes + sizeof(glyphs_),
+             atlas.gpuBytes);
+}
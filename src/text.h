@@ -0,0 +1,76 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <allegro5/allegro5.h>
+#include <allegro5/allegro_font.h>
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <memory>
+#include <string_view>
+
+#include "memory.h"
+
+// Builds a line of text into a fixed buffer without printf.
+class TextLine {
+ public:
+  TextLine();
+
+  TextLine& operator<<(std::string_view text);
+  template <std::integral T>
+  TextLine& operator<<(T value) {
+    auto [end, error] = std::to_chars(buffer_.data() + length_,
+                                      buffer_.data() + buffer_.size(), value);
+    if (error == std::errc()) {
+      length_ = end - buffer_.data();
+    }
+    return *this;
+  }
+  // Fixed point with one decimal, enough for the overlay's timings.
+  TextLine& fixed(double value);
+
+  std::string_view view() const;
+  void clear();
+
+ private:
+  std::array<char, 128> buffer_;
+  size_t length_;
+};
+
+// Printable ASCII of one TTF font size pre-rasterized into a single atlas
+// bitmap. Drawing between begin() and end() holds bitmap drawing, so all
+// text drawn in that span goes out as one batch.
+class TextRenderer {
+ public:
+  TextRenderer(const char* path, int size);
+
+  int lineHeight() const;
+  int width(std::string_view text) const;
+
+  void begin() const;
+  void end() const;
+  void draw(ALLEGRO_COLOR color, float x, float y,
+            std::string_view text) const;
+  void draw(ALLEGRO_COLOR color, float x, float y, int value) const;
+  void draw(ALLEGRO_COLOR color, float x, float y, const TextLine& line) const;
+
+  void reportMemory(MemoryReport& report, std::string_view name) const;
+
+ private:
+  static constexpr int FIRST_GLYPH = 32;
+  static constexpr int LAST_GLYPH = 126;
+
+  struct Glyph {
+    int x, y, w, h;
+    int offsetX, offsetY;
+    int advance;
+  };
+
+ private:
+  std::unique_ptr<ALLEGRO_BITMAP, void (*)(ALLEGRO_BITMAP*)> atlas_;
+  std::array<Glyph, LAST_GLYPH - FIRST_GLYPH + 1> glyphs_;
+  int line_height_;
+};
+
+#endif  // TEXT_H
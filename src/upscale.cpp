@@ -0,0 +1,80 @@
+#include "upscale.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UPSCALE_SSE2 1
+#endif
+
+namespace {
+void scale_row_scalar(const uint32_t* src, int width, uint32_t* dst,
+                      int factor) {
+  for (int x = 0; x < width; ++x) {
+    uint32_t pixel = src[x];
+    for (int i = 0; i < factor; ++i) {
+      *dst++ = pixel;
+    }
+  }
+}
+
+#ifdef UPSCALE_SSE2
+void scale_row_x2(const uint32_t* src, int width, uint32_t* dst) {
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x),
+                     _mm_unpacklo_epi32(pixels, pixels));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x + 4),
+                     _mm_unpackhi_epi32(pixels, pixels));
+  }
+  scale_row_scalar(src + x, width - x, dst + 2 * x, 2);
+}
+
+void scale_row_x4(const uint32_t* src, int width, uint32_t* dst) {
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+    __m128i* out = reinterpret_cast<__m128i*>(dst + 4 * x);
+    _mm_storeu_si128(out, _mm_shuffle_epi32(pixels, 0x00));
+    _mm_storeu_si128(out + 1, _mm_shuffle_epi32(pixels, 0x55));
+    _mm_storeu_si128(out + 2, _mm_shuffle_epi32(pixels, 0xaa));
+    _mm_storeu_si128(out + 3, _mm_shuffle_epi32(pixels, 0xff));
+  }
+  scale_row_scalar(src + x, width - x, dst + 4 * x, 4);
+}
+#endif
+
+void scale_row(const uint32_t* src, int width, uint32_t* dst, int factor) {
+  if (factor == 1) {
+    std::memcpy(dst, src, width * sizeof(uint32_t));
+    return;
+  }
+#ifdef UPSCALE_SSE2
+  if (factor == 2) {
+    scale_row_x2(src, width, dst);
+    return;
+  }
+  if (factor == 4) {
+    scale_row_x4(src, width, dst);
+    return;
+  }
+#endif
+  scale_row_scalar(src, width, dst, factor);
+}
+}  // namespace
+
+void upscale_nearest(const uint8_t* src, ptrdiff_t srcStride, int width,
+                     int height, uint8_t* dst, ptrdiff_t dstStride,
+                     int factor) {
+  size_t rowBytes = static_cast<size_t>(width) * factor * sizeof(uint32_t);
+  for (int y = 0; y < height; ++y) {
+    uint8_t* first = dst + y * factor * dstStride;
+    scale_row(reinterpret_cast<const uint32_t*>(src + y * srcStride), width,
+              reinterpret_cast<uint32_t*>(first), factor);
+    // The remaining output rows of this source row are plain copies.
+    for (int i = 1; i < factor; ++i) {
+      std::memcpy(first + i * dstStride, first, rowBytes);
+    }
+  }
+}
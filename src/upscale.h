@@ -0,0 +1,14 @@
+#ifndef UPSCALE_H
+#define UPSCALE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Nearest-neighbor integer upscale of 32-bit pixels. Strides are in bytes
+// and may be negative (bottom-up locked bitmaps). Factors 2 and 4 use SSE2
+// when available; other factors use the scalar path.
+void upscale_nearest(const uint8_t* src, ptrdiff_t srcStride, int width,
+                     int height, uint8_t* dst, ptrdiff_t dstStride,
+                     int factor);
+
+#endif  // UPSCALE_H
@@ -0,0 +1,23 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// Zobrist keys are derived on demand instead of stored in a table, so the
+// key set does not grow with the map: key(index, value) is a splitmix64 of
+// the two packed together. A state hash is the XOR of the keys of all of its
+// features and is updated incrementally by XORing a feature's old key out and
+// its new key in.
+
+constexpr uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+constexpr uint64_t zobrist_key(uint64_t index, uint32_t value) {
+  return splitmix64(splitmix64(index) ^ value);
+}
+
+#endif  // ZOBRIST_H